@@ -0,0 +1,37 @@
+include(FetchContent)
+
+# Fetch zlib and build it as a static library, so the plugin carries no runtime dependency Logic doesn't ship.
+if(NOT TARGET adb_zlib)
+    FetchContent_Declare(
+        zlib
+        GIT_REPOSITORY https://github.com/madler/zlib.git
+        GIT_TAG        v1.3.1
+        GIT_SHALLOW    True
+        GIT_PROGRESS   True
+    )
+
+    FetchContent_GetProperties(zlib)
+
+    if(NOT zlib_POPULATED)
+        FetchContent_Populate(zlib)
+    endif()
+
+    # only the stream functions are used, the gz* file functions are left out
+    add_library(adb_zlib STATIC
+        ${zlib_SOURCE_DIR}/adler32.c
+        ${zlib_SOURCE_DIR}/compress.c
+        ${zlib_SOURCE_DIR}/crc32.c
+        ${zlib_SOURCE_DIR}/deflate.c
+        ${zlib_SOURCE_DIR}/inffast.c
+        ${zlib_SOURCE_DIR}/inflate.c
+        ${zlib_SOURCE_DIR}/inftrees.c
+        ${zlib_SOURCE_DIR}/trees.c
+        ${zlib_SOURCE_DIR}/uncompr.c
+        ${zlib_SOURCE_DIR}/zutil.c
+    )
+    target_include_directories(adb_zlib PUBLIC ${zlib_SOURCE_DIR})
+    set_target_properties(adb_zlib PROPERTIES POSITION_INDEPENDENT_CODE ON)
+    if(MSVC)
+        target_compile_definitions(adb_zlib PRIVATE _CRT_SECURE_NO_DEPRECATE _CRT_NONSTDC_NO_DEPRECATE)
+    endif()
+endif()
@@ -17,6 +17,7 @@
 
 /* Calculate sample count given rate and period */
 #define mSampleCount(val, rate) (((U64)(val) * (rate)) / 1000000)
+#define mSampleCountNs(val, rate) (((U64)(val) * (rate)) / 1000000000)
 
 /* Calculate min/max sample count at given sample rate with given error */
 #define mMaxSampleCount(val, err, rate) (mSampleCount(mAddPercent(val, err), rate))
@@ -31,6 +32,8 @@ ADBAnalyzer::ADBAnalyzer() : mSettings(new ADBAnalyzerSettings()), Analyzer2(),
 ADBAnalyzer::~ADBAnalyzer()
 {
 	KillThread();
+	mStream.Stop();
+	mDecodeLag.Stop();
 }
 
 void ADBAnalyzer::SetupResults()
@@ -42,8 +45,16 @@ void ADBAnalyzer::SetupResults()
 
 void ADBAnalyzer::WorkerThread()
 {
-	/* Retrieve input channel and sample rate */
-	mADB = GetAnalyzerChannelData(mSettings->mInputChannel);
+	/* Retrieve input channel, suppressing pulses narrower than the glitch filter */
+	U64 uiMinPulseSamples = mSampleCountNs(mSettings->mGlitchFilterNs, this->GetSampleRate());
+	mADB.Initialize(GetAnalyzerChannelData(mSettings->mInputChannel), uiMinPulseSamples);
+
+	/* Retrieve timing tolerances */
+	mADBPctErrorHost = mSettings->mHostErrorPct;
+	mADBPctErrorDevice = mSettings->mDeviceErrorPct;
+	mADBLowTimePctError = mSettings->mLowTimeErrorPct;
+	mADBStopToStartTimeMin = mSettings->mStopToStartMinUs;
+	mADBStopToStartTimeMax = mSettings->mStopToStartMaxUs;
 
 	/* Calculate min and max attention period in samples */
 	mAttentionMin = mMinSampleCount(mADBAttentionTime, mADBPctErrorHost, this->GetSampleRate());
@@ -69,30 +80,13 @@ void ADBAnalyzer::WorkerThread()
 	mHostOneHighMin = mMinSampleCount(mPercent(mHostBittimeMin, (100 - mADBLowTimeBitCellPctOne) - mADBLowTimePctError), 0, this->GetSampleRate());
 	mHostOneHighMax = mMaxSampleCount(mPercent(mHostBittimeMax, (100 - mADBLowTimeBitCellPctOne) + mADBLowTimePctError), 0, this->GetSampleRate());
 
-	/* Calculate device minimum and maximum bit time */
-	double mDeviceBittimeMin = mSubPercent(mADBBitCellTime, mADBPctErrorDevice);
-	double mDeviceBittimeMax = mAddPercent(mADBBitCellTime, mADBPctErrorDevice);
-
-	/* Device to host min and max zero low and high period */
-	mDeviceZeroLowMin = mMinSampleCount(mPercent(mDeviceBittimeMin, mADBLowTimeBitCellPctZero - mADBLowTimePctError), 0, this->GetSampleRate());
-	mDeviceZeroLowMax = mMaxSampleCount(mPercent(mDeviceBittimeMax, mADBLowTimeBitCellPctZero + mADBLowTimePctError), 0, this->GetSampleRate());
-	mDeviceZeroHighMin = mMinSampleCount(mPercent(mDeviceBittimeMin, (100 - mADBLowTimeBitCellPctZero) - mADBLowTimePctError), 0, this->GetSampleRate());
-	mDeviceZeroHighMax = mMaxSampleCount(mPercent(mDeviceBittimeMax, (100 - mADBLowTimeBitCellPctZero) + mADBLowTimePctError), 0, this->GetSampleRate());
-
-	/* Device to host min and max zero low and high period */
-	mDeviceOneLowMin = mMinSampleCount(mPercent(mDeviceBittimeMin, mADBLowTimeBitCellPctOne - mADBLowTimePctError), 0, this->GetSampleRate());
-	mDeviceOneLowMax = mMaxSampleCount(mPercent(mDeviceBittimeMax, mADBLowTimeBitCellPctOne + mADBLowTimePctError), 0, this->GetSampleRate());
-	mDeviceOneHighMin = mMinSampleCount(mPercent(mDeviceBittimeMin, (100 - mADBLowTimeBitCellPctOne) - mADBLowTimePctError), 0, this->GetSampleRate());
-	mDeviceOneHighMax = mMaxSampleCount(mPercent(mDeviceBittimeMax, (100 - mADBLowTimeBitCellPctOne) + mADBLowTimePctError), 0, this->GetSampleRate());
+	/* Calculate device bit and stop bit periods from nominal bit cell */
+	CalculateDeviceLimits(mADBBitCellTime, mADBPctErrorDevice);
 
 	/* Host stop bit low time */
 	mHostStopMin = mMinSampleCount(mADBStopTime, mADBPctErrorHost, this->GetSampleRate());
 	// mHostStopMax = mMaxSampleCount(mADBStopTime, mADBPctErrorHost, this->GetSampleRate());
 
-	/* Device stop bit low time */
-	mDeviceStopMin = mMinSampleCount(mADBStopTime, mADBPctErrorDevice, this->GetSampleRate());
-	// mDeviceStopMax = mMaxSampleCount(mADBStopTime, mADBPctErrorDevice, this->GetSampleRate());
-
 	/* Global reset min time */
 	mGlobalReset = mSampleCount(mADBGlobalResetTime, this->GetSampleRate());
 
@@ -104,8 +98,98 @@ void ADBAnalyzer::WorkerThread()
 	mADBStopToStartMin = mSampleCount(mADBStopToStartTimeMin, this->GetSampleRate());
 	mADBStopToStartMax = mSampleCount(mADBStopToStartTimeMax, this->GetSampleRate());
 
+	/*
+	** Retain log of the previous decode if it came from the same capture and
+	** channel, its segments may be replayed rather than decoded again
+	*/
+	std::vector<U64> auiLimits = GetSampleLimits();
+	mPrevDecodeLog.Swap(mDecodeLog);
+	if (mPrevDecodeLog.IsCompatible(mSettings->mInputChannel, this->GetSampleRate(), uiMinPulseSamples))
+	{
+		mLimitChange = mPrevDecodeLog.GetLimitChange(auiLimits);
+	}
+	else
+	{
+		mPrevDecodeLog.Invalidate();
+		mLimitChange = UINT64_MAX;
+	}
+	mReplaySegment = 0;
+	mReplayedSegments = 0;
+
+	/* Analytics are rebuilt from every transaction, replayed or decoded */
+	mResults->GetAnalytics().Reset(this->GetSampleRate(), mSettings->mUtilizationWindowMs);
+
+	/* Register timeline likewise (not kept in statistics only mode, it grows with the capture) */
+	mResults->GetRegisterTimeline().Reset();
+
+	/* Compile transaction patterns (validated with settings), hiding non matches needs a pattern */
+	std::string match_error;
+	mMatcher.Compile(mSettings->mMatchPatterns.c_str(), &match_error);
+	mMatchesOnly = mSettings->mMatchesOnly && !mMatcher.IsEmpty();
+	mStagingMarkers = false;
+	mStagingFrames = false;
+	mStagedMarkers.clear();
+	mStagedFrames.clear();
+
+	/* Room for a full transaction up front, clearing retains it so staging never allocates while decoding */
+	mStagedMarkers.reserve(mStagedMarkersReserve);
+	mStagedFrames.reserve(1 + 8);
+
+	/* Marker density */
+	mMarkerVerbosity = mSettings->mMarkerVerbosity;
+	mMarkFailedOrServiceRequestOnly = mSettings->mMarkFailedOrServiceRequestOnly;
+
+	/* Publish transactions live if wanted (a consumer stays connected across decodes) */
+	if (mSettings->mStreamPath.empty())
+	{
+		mStream.Stop();
+	}
+	else
+	{
+		mStream.Start(mSettings->mStreamPath.c_str(), this->GetSampleRate());
+	}
+
+	/* Measure decode lag if wanted, from where decoding starts */
+	if (mSettings->mDecodeLagLogPath.empty())
+	{
+		mDecodeLag.Stop();
+	}
+	else
+	{
+		mDecodeLag.Start(mSettings->mDecodeLagLogPath.c_str(), this->GetSampleRate(), mADB.GetSampleNumber());
+	}
+
+	/* Statistics only mode must run in constant memory, so doesn't log the decode */
+	mStatisticsOnly = mSettings->mStatisticsOnly;
+
+	/* Adaptive timing depends upon every response before, so can't reuse or log the decode either */
+	mAdaptiveDeviceTiming = mSettings->mAdaptiveDeviceTiming;
+	for (U32 i = 0; i < 16; i++) mDeviceBitCellTime[i] = 0.0;
+	if (mAdaptiveDeviceTiming)
+	{
+		mPrevDecodeLog.Invalidate();
+	}
+
+	if (mStatisticsOnly || mAdaptiveDeviceTiming)
+	{
+		mDecodeLog.Invalidate();
+	}
+	else
+	{
+		mDecodeLog.Reset(mSettings->mInputChannel, this->GetSampleRate(), uiMinPulseSamples, auiLimits);
+	}
+
+	/* Start first segment */
+	mSegment.uiStartSample = mADB.GetSampleNumber();
+	mSegment.uiSlack = UINT64_MAX;
+	mSegment.uiFirstEvent = 0;
+	mSegmentFirstEdgePending = true;
+	mSegmentCommitted = false;
+	mSlack = UINT64_MAX;
+
 	/* Reset state */
 	ADBState mState = Attention;
+	mPacketID = 0;
 
 	/* Command and data values */
 	U8 mCommand;
@@ -121,13 +205,35 @@ void ADBAnalyzer::WorkerThread()
 
 	for (;;)
 	{
+		/* Reuse output of previous decode from here if possible */
+		if ((Attention == mState) && ReplaySegments())
+		{
+			continue;
+		}
+
+		/* Capture packet ID, to determine if a transaction completes */
+		U64 uiPacketID = mPacketID;
+
 		/* Capture location of current edge and value */
-		mADB->AdvanceToNextEdge();
-		U64 curr_edge_location = mADB->GetSampleNumber();
-		bool curr_edge_val = (BIT_HIGH == mADB->GetBitState());
+		mADB.AdvanceToNextEdge();
+		U64 curr_edge_location = mADB.GetSampleNumber();
+		bool curr_edge_val = (BIT_HIGH == mADB.GetBitState());
+
+		/* Capture first edge of segment */
+		if (mSegmentFirstEdgePending)
+		{
+			mSegment.uiFirstEdge = curr_edge_location;
+			mSegmentFirstEdgePending = false;
+		}
+
+		/* Used every transition captured so far, looking on waits for more (only checked between transactions) */
+		if (mDecodeLag.IsActive() && (Attention == mState) && !mADB.MoreEdgesAvailable())
+		{
+			mDecodeLag.CaughtUp(mADB.GetFurthestSampleNumber());
+		}
 
 		/* Retrieve next edge location (without advancing) */
-		U64 next_edge_location = mADB->GetSampleOfNextEdge();
+		U64 next_edge_location = mADB.GetSampleOfNextEdge();
 
 		/* Calculate samples between edges */
 		U64 edge_period = next_edge_location - curr_edge_location;
@@ -140,13 +246,19 @@ void ADBAnalyzer::WorkerThread()
 		U64 data_start_location;
 
 		/* Check for global reset (low for minimum period) */
-		if (!curr_edge_val && (edge_period >= mGlobalReset))
+		if (!curr_edge_val && AtLeast(edge_period, mGlobalReset))
 		{
 			/* Global reset asserted, reset state machine */
 			mState = Attention;
 
+			/* Abandon output held back for transaction in progress */
+			DiscardStaged();
+
 			/* Add marker */
-			mResults->AddMarker(curr_edge_location, AnalyzerResults::Square, mSettings->mInputChannel);
+			AddMarker(curr_edge_location, AnalyzerResults::Square);
+
+			/* Count it */
+			OutputGlobalReset(curr_edge_location, next_edge_location);
 		}
 
 		/* Assume state machine should reset */
@@ -158,30 +270,29 @@ void ADBAnalyzer::WorkerThread()
 			case Attention:
 			{
 				if (	!curr_edge_val
-					 && (edge_period >= mAttentionMin)
-					 && (edge_period <= mAttentionMax)
+					 && InWindow(edge_period, mAttentionMin, mAttentionMax)
 				   )
 				{
 					/* Attention within spec, advance state */
 					mNextState = Sync;
+					mTransactionStart = curr_edge_location;
 
 					/* Start new packet */
-					mResults->CancelPacketAndStartNewPacket();
+					StartPacket();
 				}
 				break;
 			}
 			case Sync:
 			{
 				if (	curr_edge_val
-					 && (edge_period >= mSyncMin)
-					 && (edge_period <= mSyncMax)
+					 && InWindow(edge_period, mSyncMin, mSyncMax)
 				   )
 				{
 					/* Sync within spec, advance state */
 					mNextState = CommandStop;
 
 					/* Add marker */
-					mResults->AddMarker(curr_edge_location, AnalyzerResults::Start, mSettings->mInputChannel);
+					AddMarker(curr_edge_location, AnalyzerResults::Start);
 				}
 				break;
 			}
@@ -197,26 +308,23 @@ void ADBAnalyzer::WorkerThread()
 					bCmdIsListen = (Listen == ((mCommand >> mADBCommandCodeShift) & mADBCommandCodeMask));
 
 					/* Update current / next edges and calculate period */
-					curr_edge_location = mADB->GetSampleNumber();
-					curr_edge_val = (BIT_HIGH == mADB->GetBitState());
-					next_edge_location = mADB->GetSampleOfNextEdge();
+					curr_edge_location = mADB.GetSampleNumber();
+					curr_edge_val = (BIT_HIGH == mADB.GetBitState());
+					next_edge_location = mADB.GetSampleOfNextEdge();
 					edge_period = next_edge_location - curr_edge_location;
 
 					if (	!curr_edge_val
-						 && (edge_period >= mHostStopMin)
-						 && (edge_period <= mServiceRequestMax)
+						 && InWindow(edge_period, mHostStopMin, mServiceRequestMax)
 					   )
 					{
 						/* Stop within spec, advance state */
 						mNextState = StopToStart;
 
 						/* Check for service request signal */
-						service_request_cmd = (		(edge_period >= mServiceRequestMin)
-												 && (edge_period <= mServiceRequestMax)
-											  );
+						service_request_cmd = InWindow(edge_period, mServiceRequestMin, mServiceRequestMax);
 
 						/* Flag edge with arrow for service request, or stop otherwise */
-						mResults->AddMarker(next_edge_location, service_request_cmd ? AnalyzerResults::UpArrow : AnalyzerResults::Stop, mSettings->mInputChannel);
+						AddMarker(next_edge_location, service_request_cmd ? AnalyzerResults::UpArrow : AnalyzerResults::Stop);
 
 						/* Capture end location */
 						command_end_location = curr_edge_location;
@@ -229,27 +337,39 @@ void ADBAnalyzer::WorkerThread()
 			}
 			case StopToStart:
 			{
-				if (	(edge_period >= mADBStopToStartMin)
-					 && (edge_period <= mADBStopToStartMax)
-				   )
+				if (InWindow(edge_period, mADBStopToStartMin, mADBStopToStartMax))
 				{
 					/* Stop to start time within spec, advance state */
 					mNextState = DataStartLow;
 
 					/* Reset data length */
 					mDataLen = 0;
+
+					/* Centre device windows on bit cell tracked for address being talked to, until known accept any start bit in range */
+					if (mAdaptiveDeviceTiming && !bCmdIsListen)
+					{
+						U8 uiAddr = ((mCommand >> mADBCommandAddrShift) & mADBCommandAddrMask);
+						if (mDeviceBitCellTime[uiAddr] > 0.0)
+						{
+							CalculateDeviceLimits(mDeviceBitCellTime[uiAddr], mADBPctErrorDevice);
+						}
+						else
+						{
+							CalculateDeviceLimits(mADBBitCellTime, mADBAdaptivePctLimit);
+						}
+					}
 				}
 				else
 				{
 					/* Stop to start out of spec, output command and reset */
-					OutputBytesForTable(mCommand, NULL, 0, service_request_cmd, command_start_location, command_end_location);
+					OutputBytesForTable(mCommand, NULL, 0, service_request_cmd, mTransactionStart, command_start_location, command_end_location);
 				}
 				break;
 			}
 			case DataStartLow:
 			{
-				if (	(bCmdIsListen && (edge_period >= mHostOneLowMin) && (edge_period <= mHostOneLowMax))
-					 || (!bCmdIsListen && (edge_period >= mDeviceOneLowMin) && (edge_period <= mDeviceOneLowMax))
+				if (	(bCmdIsListen && InWindow(edge_period, mHostOneLowMin, mHostOneLowMax))
+					 || (!bCmdIsListen && InWindow(edge_period, mDeviceOneLowMin, mDeviceOneLowMax))
 				   )
 				{
 					/* Start bit low period within spec, advance state */
@@ -257,20 +377,33 @@ void ADBAnalyzer::WorkerThread()
 
 					/* Capture location for data start */
 					data_start_location = curr_edge_location;
+
+					/* Capture start of response and start bit low period, for adaptive timing */
+					mDeviceResponseStart = curr_edge_location;
+					mDeviceStartBitLow = edge_period;
 				}
 				break;
 			}
 			case DataStartHigh:
 			{
-				if (	(bCmdIsListen && (edge_period >= mHostOneHighMin) && (edge_period <= mHostOneHighMax))
-					 || (!bCmdIsListen && (edge_period >= mDeviceOneHighMin) && (edge_period <= mDeviceOneHighMax))
+				if (	(bCmdIsListen && InWindow(edge_period, mHostOneHighMin, mHostOneHighMax))
+					 || (!bCmdIsListen && InWindow(edge_period, mDeviceOneHighMin, mDeviceOneHighMax))
 				   )
 				{
 					/* Start bit high period within spec, advance state */
 					mNextState = DataStop;
 
+					/* Re-centre device windows on bit cell measured from start bit, averaged with that tracked */
+					if (mAdaptiveDeviceTiming && !bCmdIsListen)
+					{
+						double dBitCellTime = SamplesToUs(mDeviceStartBitLow + edge_period);
+						U8 uiAddr = ((mCommand >> mADBCommandAddrShift) & mADBCommandAddrMask);
+						if (mDeviceBitCellTime[uiAddr] > 0.0) dBitCellTime = (dBitCellTime + mDeviceBitCellTime[uiAddr]) / 2;
+						CalculateDeviceLimits(LimitBitCellTime(dBitCellTime), mADBPctErrorDevice);
+					}
+
 					/* Add marker */
-					mResults->AddMarker(data_start_location, AnalyzerResults::Start, mSettings->mInputChannel);
+					AddMarker(data_start_location, AnalyzerResults::Start);
 				}
 				break;
 			}
@@ -280,9 +413,9 @@ void ADBAnalyzer::WorkerThread()
 				for (int i = 0; i < 8; i++)
 				{
 					/* Update current and next locations in order to handle stop bit */
-					curr_edge_location = mADB->GetSampleNumber();
-					curr_edge_val = (BIT_HIGH == mADB->GetBitState());
-					next_edge_location = mADB->GetSampleOfNextEdge();
+					curr_edge_location = mADB.GetSampleNumber();
+					curr_edge_val = (BIT_HIGH == mADB.GetBitState());
+					next_edge_location = mADB.GetSampleOfNextEdge();
 
 					/* Capture start position for byte */
 					mDataStart[i] = curr_edge_location;
@@ -294,7 +427,7 @@ void ADBAnalyzer::WorkerThread()
 						mDataLen++;
 
 						/* Capture end position for byte */
-						mDataEnd[i] = mADB->GetSampleNumber();
+						mDataEnd[i] = mADB.GetSampleNumber();
 					}
 					else
 					{
@@ -308,18 +441,16 @@ void ADBAnalyzer::WorkerThread()
 					/* Minimum of two bytes has been transferred, check for stop bit */
 					edge_period = next_edge_location - curr_edge_location;
 					if (	!curr_edge_val
-						 && (	(bCmdIsListen && (edge_period >= mHostStopMin) && (edge_period <= mServiceRequestMax))
-							 || (!bCmdIsListen && (edge_period >= mDeviceStopMin) && (edge_period <= mServiceRequestMax))
+						 && (	(bCmdIsListen && InWindow(edge_period, mHostStopMin, mServiceRequestMax))
+							 || (!bCmdIsListen && InWindow(edge_period, mDeviceStopMin, mServiceRequestMax))
 						    )
 					   )
 					{
 						/* Stop within spec, check for service request signal */
-						service_request_data = (	(edge_period >= mServiceRequestMin)
-												 && (edge_period <= mServiceRequestMax)
-											   );
+						service_request_data = InWindow(edge_period, mServiceRequestMin, mServiceRequestMax);
 
 						/* Flag edge with arrow for service request, or stop otherwise */
-						mResults->AddMarker(next_edge_location, service_request_data ? AnalyzerResults::UpArrow : AnalyzerResults::Stop, mSettings->mInputChannel);
+						AddMarker(next_edge_location, service_request_data ? AnalyzerResults::UpArrow : AnalyzerResults::Stop);
 
 						/* Output data bytes */
 						for (int i = 0; i < mDataLen; i++)
@@ -327,8 +458,14 @@ void ADBAnalyzer::WorkerThread()
 							OutputByteForDisplayAndExport(true, ((i == (mDataLen - 1)) && service_request_data), mData[i], mDataStart[i], mDataEnd[i]);
 						}
 
+						/* Track device bit cell over whole response */
+						if (mAdaptiveDeviceTiming && !bCmdIsListen)
+						{
+							TrackDeviceBitCellTime(mCommand, mDataEnd[mDataLen - 1] - mDeviceResponseStart, 1 + (8 * mDataLen));
+						}
+
 						/* Output command and data */
-						OutputBytesForTable(mCommand, mData, mDataLen, service_request_cmd | service_request_data, command_start_location, curr_edge_location);
+						OutputBytesForTable(mCommand, mData, mDataLen, service_request_cmd | service_request_data, mTransactionStart, command_start_location, curr_edge_location);
 					}
 				}
 				break;
@@ -340,11 +477,23 @@ void ADBAnalyzer::WorkerThread()
 			}
 		}
 
+		/* Transaction abandoned part way through */
+		if ((Attention != mState) && (Attention == mNextState) && (uiPacketID == mPacketID))
+		{
+			OutputTimingViolation(mState, mTransactionStart, mADB.GetSampleNumber());
+		}
+
 		/* Apply calculated next state */
 		mState = mNextState;
 
+		/* Transaction boundary, close segment */
+		if ((Attention == mState) && mSegmentCommitted)
+		{
+			EndSegment();
+		}
+
 		/* Report how far we've got through processing samples */
-		ReportProgress(mADB->GetSampleNumber());
+		ReportProgress(mADB.GetSampleNumber());
 
 		/* Check if this glorious game should come to an end? */
 		CheckIfThreadShouldExit();
@@ -363,25 +512,25 @@ bool ADBAnalyzer::ReadByte(bool bHostToDevice, U8 *pbyOutput)
 	for (int i = 0; i < 8; i++)
 	{
 		/* Retrieve current edge location */
-		U64 curr_edge_location = mADB->GetSampleNumber();
+		U64 curr_edge_location = mADB.GetSampleNumber();
 
 		/* Retrieve next edge location (without advancing) */
-		U64 next_edge_location = mADB->GetSampleOfNextEdge();
+		U64 next_edge_location = mADB.GetSampleOfNextEdge();
 
 		/* Calculate samples between edges */
 		U64 edge_period = next_edge_location - curr_edge_location;
 
 		U8 uiBit;
 
-		if (	(bHostToDevice && (edge_period >= mHostOneLowMin) && (edge_period <= mHostOneLowMax))
-			 || (!bHostToDevice && (edge_period >= mDeviceOneLowMin) && (edge_period <= mDeviceOneLowMax))
+		if (	(bHostToDevice && InWindow(edge_period, mHostOneLowMin, mHostOneLowMax))
+			 || (!bHostToDevice && InWindow(edge_period, mDeviceOneLowMin, mDeviceOneLowMax))
 		   )
 		{
 			/* Edge period is correct for a one */
 			uiBit = 1;
 		}
-		else if (	(bHostToDevice && (edge_period >= mHostZeroLowMin) && (edge_period <= mHostZeroLowMax))
-				 || (!bHostToDevice && (edge_period >= mDeviceZeroLowMin) && (edge_period <= mDeviceZeroLowMax))
+		else if (	(bHostToDevice && InWindow(edge_period, mHostZeroLowMin, mHostZeroLowMax))
+				 || (!bHostToDevice && InWindow(edge_period, mDeviceZeroLowMin, mDeviceZeroLowMax))
 				)
 		{
 			/* Edge period is correct for a zero */
@@ -394,17 +543,17 @@ bool ADBAnalyzer::ReadByte(bool bHostToDevice, U8 *pbyOutput)
 		}
 
 		/* Advance to next edge */
-		mADB->AdvanceToNextEdge();
+		mADB.AdvanceToNextEdge();
 
 		/* Retrieve next next edge location (without advancing) */
-		U64 next_next_edge_location = mADB->GetSampleOfNextEdge();
+		U64 next_next_edge_location = mADB.GetSampleOfNextEdge();
 
 		/* Update edge period */
 		edge_period = next_next_edge_location - next_edge_location;
 
 		if (	uiBit
-			 && (	(bHostToDevice && (edge_period >= mHostOneHighMin) && (edge_period <= mHostOneHighMax))
-				 || (!bHostToDevice && (edge_period >= mDeviceOneHighMin) && (edge_period <= mDeviceOneHighMax))
+			 && (	(bHostToDevice && InWindow(edge_period, mHostOneHighMin, mHostOneHighMax))
+				 || (!bHostToDevice && InWindow(edge_period, mDeviceOneHighMin, mDeviceOneHighMax))
 				)
 		   )
 		{
@@ -412,8 +561,8 @@ bool ADBAnalyzer::ReadByte(bool bHostToDevice, U8 *pbyOutput)
 			bSuccess = true;
 		}
 		else if (	!uiBit
-				 && (	(bHostToDevice && (edge_period >= mHostZeroHighMin) && (edge_period <= mHostZeroHighMax))
-					 || (!bHostToDevice && (edge_period >= mDeviceZeroHighMin) && (edge_period <= mDeviceZeroHighMax))
+				 && (	(bHostToDevice && InWindow(edge_period, mHostZeroHighMin, mHostZeroHighMax))
+					 || (!bHostToDevice && InWindow(edge_period, mDeviceZeroHighMin, mDeviceZeroHighMax))
 					)
 				)
 		{
@@ -427,7 +576,7 @@ bool ADBAnalyzer::ReadByte(bool bHostToDevice, U8 *pbyOutput)
 		}
 
 		/* Advance to next edge */
-		mADB->AdvanceToNextEdge();
+		mADB.AdvanceToNextEdge();
 
 		/* Add bit */
 		byData <<= 1;
@@ -442,6 +591,19 @@ bool ADBAnalyzer::ReadByte(bool bHostToDevice, U8 *pbyOutput)
 
 void ADBAnalyzer::OutputByteForDisplayAndExport(bool bIsData, bool bServiceRequested, U8 byData, U64 uiStart, U64 uiEnd)
 {
+	/* Record for reuse by subsequent decode */
+	ADBDecodeEvent event;
+	event.eType = ByteEvent;
+	event.uiStart = uiStart;
+	event.uiEnd = uiEnd;
+	event.uiValue = byData;
+	event.bIsData = bIsData;
+	event.bServiceRequested = bServiceRequested;
+	mDecodeLog.AddEvent(event);
+
+	/* Statistics only mode keeps no per byte results */
+	if (mStatisticsOnly) return;
+
 	Frame frame;
 
 	/* Display byte */
@@ -449,34 +611,463 @@ void ADBAnalyzer::OutputByteForDisplayAndExport(bool bIsData, bool bServiceReque
 	frame.mEndingSampleInclusive = uiEnd;
 	frame.mData1 = byData; /* data byte */
 	frame.mData2 = mPacketID; /* index of packet it goes with */
+	frame.mType = ByteFrame;
 	frame.mFlags = 0;
 	if (bIsData) frame.mFlags |= DATA_BYTE_FLAG;
 	if (bServiceRequested) frame.mFlags |= SERVICE_REQUEST_FLAG;
-	mResults->AddFrame(frame);
+
+	/* Hold back until transaction is known to match */
+	if (mStagingFrames)
+	{
+		mStagedFrames.push_back(frame);
+		return;
+	}
+
+	AddByteFrame(frame);
 }
 
-void ADBAnalyzer::OutputBytesForTable(U8 byCommand, U8 *pabyData, U8 uiDataLen, bool bServiceRequested, U64 uiStart, U64 uiEnd)
+void ADBAnalyzer::AddByteFrame(const Frame& frame)
 {
+	U64 frame_index = mResults->AddFrame(frame);
+
+	/* Track frames covered by packet for the packet index */
+	if (!(frame.mFlags & DATA_BYTE_FLAG)) mPacketFirstFrame = frame_index;
+	mPacketLastFrame = frame_index;
+}
+
+void ADBAnalyzer::OutputBytesForTable(U8 byCommand, U8 *pabyData, U8 uiDataLen, bool bServiceRequested, U64 uiAttention, U64 uiStart, U64 uiEnd)
+{
+	/* Record for reuse by subsequent decode */
+	ADBDecodeEvent event;
+	event.eType = TransactionEvent;
+	event.uiAttention = uiAttention;
+	event.uiStart = uiStart;
+	event.uiEnd = uiEnd;
+	event.uiValue = byCommand;
+	event.bServiceRequested = bServiceRequested;
+	event.uiDataLen = uiDataLen;
+	for (U8 i = 0; i < uiDataLen; i++) event.abyData[i] = pabyData[i];
+	mDecodeLog.AddEvent(event);
+
+	/* Count it */
+	bool bServiceRequestStorm = mResults->GetStatistics().AddTransaction(byCommand, uiDataLen, bServiceRequested, uiAttention, uiEnd);
+	mResults->GetAnalytics().AddTransaction(byCommand, uiDataLen, bServiceRequested, uiAttention, uiEnd);
+
+	/* Publish to live stream, whatever is displayed */
+	mStream.Publish(byCommand, pabyData, uiDataLen, bServiceRequested, uiAttention, uiEnd);
+
+	/* Measure lag at each commit, from the furthest point seen (the commit itself trails that by however long the transaction took to be seen to end) */
+	if (mDecodeLag.IsActive())
+	{
+		mDecodeLag.Update(mADB.GetFurthestSampleNumber(), mADB.MoreEdgesAvailable());
+	}
+
+	/* Track register values */
+	if (!mStatisticsOnly)
+	{
+		mResults->GetRegisterTimeline().AddTransaction(byCommand, pabyData, uiDataLen, uiEnd);
+	}
+
+	/* Segment may now end */
+	mSegmentCommitted = true;
+
+	/* Increment packet ID */
+	mPacketID++;
+
+	if (mStatisticsOnly)
+	{
+		/* Output only the transaction which turns a run of service requests into a storm */
+		if (bServiceRequestStorm)
+		{
+			OutputEventFrame(ServiceRequestStormFrame, "srq_storm", uiStart, uiEnd, NULL);
+		}
+		return;
+	}
+
+	/* Check against patterns */
+	int iMatch = mMatcher.Match(byCommand, pabyData, uiDataLen, bServiceRequested);
+
+	/* Drop everything held back unless transaction matched, when only matches are wanted */
+	if (mMatchesOnly && (iMatch < 0))
+	{
+		DiscardStaged();
+		return;
+	}
+
+	/* Output held back markers (unless only wanted for service requests) and frames */
+	if (!mMarkFailedOrServiceRequestOnly || bServiceRequested)
+	{
+		OutputStagedMarkers();
+	}
+	for (size_t i = 0; i < mStagedFrames.size(); i++)
+	{
+		AddByteFrame(mStagedFrames[i]);
+	}
+	DiscardStaged();
+
+	/* Mark matches at their attention pulse */
+	if (iMatch >= 0)
+	{
+		OutputMarker(uiAttention, AnalyzerResults::Dot);
+	}
+
 	/* Decode command */
 	U8 uiAddr = ((byCommand >> mADBCommandAddrShift) & mADBCommandAddrMask);
 	ADBCommand eCode = ADBCommand((byCommand >> mADBCommandCodeShift) & mADBCommandCodeMask);
 	U8 uiReg = ((byCommand >> mADBCommandRegShift) & mADBCommandRegMask);
 
-	/* Output bytes for export / table display */
+	/*
+	** Output bytes for export / table display, tagging matches with the pattern number.
+	** The SDK allocates the frame's data, otherwise this path allocates nothing
+	** (held to by tests/ADBAllocationTest.cpp).
+	*/
 	FrameV2 frame_v2;
 	frame_v2.AddByteArray("addr", &uiAddr, sizeof(uiAddr));
 	frame_v2.AddString("cmd", CmdCodeRegToString(eCode, uiReg));
 	frame_v2.AddByteArray("reg", &uiReg, sizeof(uiReg));
 	frame_v2.AddByteArray("data", pabyData, uiDataLen);
 	frame_v2.AddBoolean("svcreq", bServiceRequested);
+	if (iMatch >= 0) frame_v2.AddInteger("match", iMatch + 1);
 	mResults->AddFrameV2(frame_v2, "adb", uiStart, uiEnd);
 	mResults->CommitResults();
 
-	/* Commit packet */
+	/* Commit packet, indexing it by start sample for time window export, and with its full span for trace export */
 	mResults->CommitPacketAndStartNewPacket();
+	mResults->AddPacketToIndex(uiAttention, uiStart, uiEnd, mPacketFirstFrame, mPacketLastFrame);
+}
 
-	/* Increment packet ID */
-	mPacketID++;
+void ADBAnalyzer::OutputTimingViolation(ADBState eState, U64 uiStart, U64 uiEnd)
+{
+	/* Record for reuse by subsequent decode */
+	ADBDecodeEvent event;
+	event.eType = TimingViolationEvent;
+	event.uiStart = uiStart;
+	event.uiEnd = uiEnd;
+	event.uiValue = U8(eState);
+	mDecodeLog.AddEvent(event);
+
+	mResults->GetStatistics().AddTimingViolation();
+
+	/* Transaction won't complete, mark it if only failures are marked, drop anything else held back for it */
+	if (mMarkFailedOrServiceRequestOnly && !mMatchesOnly)
+	{
+		OutputStagedMarkers();
+	}
+	DiscardStaged();
+
+	if (mStatisticsOnly)
+	{
+		OutputEventFrame(TimingViolationFrame, "error", uiStart, uiEnd, StateToString(eState));
+	}
+}
+
+void ADBAnalyzer::OutputGlobalReset(U64 uiStart, U64 uiEnd)
+{
+	/* Record for reuse by subsequent decode */
+	ADBDecodeEvent event;
+	event.eType = GlobalResetEvent;
+	event.uiStart = uiStart;
+	event.uiEnd = uiEnd;
+	mDecodeLog.AddEvent(event);
+
+	mResults->GetStatistics().AddGlobalReset();
+
+	if (mStatisticsOnly)
+	{
+		OutputEventFrame(GlobalResetFrame, "reset", uiStart, uiEnd, NULL);
+	}
+}
+
+void ADBAnalyzer::OutputEventFrame(ADBFrameType eType, const char* pszType, U64 uiStart, U64 uiEnd, const char* pszDetail)
+{
+	/* Frame for bubble */
+	Frame frame;
+	frame.mStartingSampleInclusive = uiStart;
+	frame.mEndingSampleInclusive = uiEnd;
+	frame.mData1 = 0;
+	frame.mData2 = mPacketID;
+	frame.mType = eType;
+	frame.mFlags = 0;
+	mResults->AddFrame(frame);
+
+	/* Frame for table */
+	FrameV2 frame_v2;
+	if (NULL != pszDetail) frame_v2.AddString("state", pszDetail);
+	mResults->AddFrameV2(frame_v2, pszType, uiStart, uiEnd);
+	mResults->CommitResults();
+}
+
+const char* ADBAnalyzer::StateToString(ADBState eState)
+{
+	switch (eState)
+	{
+		case Attention: return "attention";
+		case Sync: return "sync";
+		case CommandStop: return "command";
+		case StopToStart: return "stop_to_start";
+		case DataStartLow: return "data_start_low";
+		case DataStartHigh: return "data_start_high";
+		case DataStop: return "data";
+		default: return "unknown";
+	}
+}
+
+void ADBAnalyzer::AddMarker(U64 uiSample, AnalyzerResults::MarkerType eType)
+{
+	/* Record for reuse by subsequent decode */
+	ADBDecodeEvent event;
+	event.eType = MarkerEvent;
+	event.uiStart = uiSample;
+	event.uiValue = U8(eType);
+	mDecodeLog.AddEvent(event);
+
+	/* Statistics only mode keeps no markers */
+	if (mStatisticsOnly) return;
+
+	/* Hold back until transaction is known to match / fail / carry a service request */
+	if (mStagingMarkers)
+	{
+		mStagedMarkers.push_back(std::make_pair(uiSample, eType));
+		return;
+	}
+
+	OutputMarker(uiSample, eType);
+}
+
+void ADBAnalyzer::OutputMarker(U64 uiSample, AnalyzerResults::MarkerType eType)
+{
+	if (MarkersNone == mMarkerVerbosity) return;
+
+	/* Service request arrows and global reset squares only */
+	if (	(MarkersServiceRequestsAndResets == mMarkerVerbosity)
+		 && (AnalyzerResults::UpArrow != eType) && (AnalyzerResults::Square != eType)
+	   )
+	{
+		return;
+	}
+
+	mResults->AddMarker(uiSample, eType, mSettings->mInputChannel);
+}
+
+void ADBAnalyzer::OutputStagedMarkers()
+{
+	for (size_t i = 0; i < mStagedMarkers.size(); i++)
+	{
+		OutputMarker(mStagedMarkers[i].first, mStagedMarkers[i].second);
+	}
+	mStagedMarkers.clear();
+}
+
+void ADBAnalyzer::StartPacket()
+{
+	/* Record for reuse by subsequent decode */
+	ADBDecodeEvent event;
+	event.eType = PacketStartEvent;
+	mDecodeLog.AddEvent(event);
+
+	mResults->CancelPacketAndStartNewPacket();
+
+	/* Hold back output of transaction, when only matches or failed / service request transactions are wanted */
+	DiscardStaged();
+	mStagingMarkers = !mStatisticsOnly && (mMatchesOnly || mMarkFailedOrServiceRequestOnly);
+	mStagingFrames = !mStatisticsOnly && mMatchesOnly;
+}
+
+void ADBAnalyzer::DiscardStaged()
+{
+	mStagingMarkers = false;
+	mStagingFrames = false;
+	mStagedMarkers.clear();
+	mStagedFrames.clear();
+}
+
+void ADBAnalyzer::EndSegment()
+{
+	/* Record segment just completed */
+	mSegment.uiEndSample = mADB.GetSampleNumber();
+	mSegment.uiSlack = mSlack;
+	mSegment.uiEndEvent = mDecodeLog.GetNumEvents();
+	mDecodeLog.AddSegment(mSegment);
+
+	/* Start next one from here */
+	mSegment.uiStartSample = mSegment.uiEndSample;
+	mSegment.uiFirstEvent = mSegment.uiEndEvent;
+	mSegmentFirstEdgePending = true;
+	mSegmentCommitted = false;
+	mSlack = UINT64_MAX;
+}
+
+bool ADBAnalyzer::ReplaySegments()
+{
+	bool bReplayed = false;
+	U64 uiLocation = mADB.GetSampleNumber();
+
+	/* Skip segments of previous decode which are behind us */
+	while (	   (mReplaySegment < mPrevDecodeLog.GetNumSegments())
+			&& (mPrevDecodeLog.GetSegment(mReplaySegment).uiStartSample < uiLocation)
+		  )
+	{
+		mReplaySegment++;
+	}
+
+	/* Release previous decode once there's nothing left of it to replay */
+	if (mPrevDecodeLog.IsValid() && (mReplaySegment >= mPrevDecodeLog.GetNumSegments()))
+	{
+		mPrevDecodeLog.Invalidate();
+		return false;
+	}
+
+	/* Replay consecutive segments starting here, if no limit has moved far enough to alter their outcome */
+	while (mReplaySegment < mPrevDecodeLog.GetNumSegments())
+	{
+		const ADBDecodeSegment& segment = mPrevDecodeLog.GetSegment(mReplaySegment);
+		if ((segment.uiStartSample != uiLocation) || (segment.uiSlack < mLimitChange))
+		{
+			/* Decode from here */
+			break;
+		}
+
+		/* Confirm capture matches the one previously decoded */
+		if (mADB.GetSampleOfNextEdge() != segment.uiFirstEdge)
+		{
+			mPrevDecodeLog.Invalidate();
+			break;
+		}
+
+		/* Output everything decoded in segment */
+		for (size_t i = segment.uiFirstEvent; i < segment.uiEndEvent; i++)
+		{
+			const ADBDecodeEvent& event = mPrevDecodeLog.GetEvent(i);
+			switch (event.eType)
+			{
+				case MarkerEvent:
+				{
+					AddMarker(event.uiStart, AnalyzerResults::MarkerType(event.uiValue));
+					break;
+				}
+				case PacketStartEvent:
+				{
+					StartPacket();
+					break;
+				}
+				case ByteEvent:
+				{
+					OutputByteForDisplayAndExport(event.bIsData, event.bServiceRequested, event.uiValue, event.uiStart, event.uiEnd);
+					break;
+				}
+				case TransactionEvent:
+				{
+					OutputBytesForTable(event.uiValue, (U8*)event.abyData, event.uiDataLen, event.bServiceRequested, event.uiAttention, event.uiStart, event.uiEnd);
+					break;
+				}
+				case TimingViolationEvent:
+				{
+					OutputTimingViolation(ADBState(event.uiValue), event.uiStart, event.uiEnd);
+					break;
+				}
+				case GlobalResetEvent:
+				{
+					OutputGlobalReset(event.uiStart, event.uiEnd);
+					break;
+				}
+				default:
+				{
+					break;
+				}
+			}
+		}
+
+		/*
+		** Continue from end of segment, which closes the current segment. That remains
+		** reusable provided limits move no further than the slack replayed segment has left.
+		*/
+		mADB.Seek(segment.uiEndSample);
+		if (mSegmentFirstEdgePending)
+		{
+			mSegment.uiFirstEdge = segment.uiFirstEdge;
+			mSegmentFirstEdgePending = false;
+		}
+		TrackMargin(segment.uiSlack - mLimitChange);
+		EndSegment();
+
+		uiLocation = segment.uiEndSample;
+		mReplaySegment++;
+		mReplayedSegments++;
+		bReplayed = true;
+
+		/* Report how far we've got through processing samples */
+		ReportProgress(uiLocation);
+		CheckIfThreadShouldExit();
+	}
+
+	return bReplayed;
+}
+
+void ADBAnalyzer::CalculateDeviceLimits(double dBitCellTime, U32 uiPctError)
+{
+	/* Calculate device minimum and maximum bit time */
+	double mDeviceBittimeMin = mSubPercent(dBitCellTime, uiPctError);
+	double mDeviceBittimeMax = mAddPercent(dBitCellTime, uiPctError);
+
+	/* Device to host min and max zero low and high period */
+	mDeviceZeroLowMin = mMinSampleCount(mPercent(mDeviceBittimeMin, mADBLowTimeBitCellPctZero - mADBLowTimePctError), 0, this->GetSampleRate());
+	mDeviceZeroLowMax = mMaxSampleCount(mPercent(mDeviceBittimeMax, mADBLowTimeBitCellPctZero + mADBLowTimePctError), 0, this->GetSampleRate());
+	mDeviceZeroHighMin = mMinSampleCount(mPercent(mDeviceBittimeMin, (100 - mADBLowTimeBitCellPctZero) - mADBLowTimePctError), 0, this->GetSampleRate());
+	mDeviceZeroHighMax = mMaxSampleCount(mPercent(mDeviceBittimeMax, (100 - mADBLowTimeBitCellPctZero) + mADBLowTimePctError), 0, this->GetSampleRate());
+
+	/* Device to host min and max zero low and high period */
+	mDeviceOneLowMin = mMinSampleCount(mPercent(mDeviceBittimeMin, mADBLowTimeBitCellPctOne - mADBLowTimePctError), 0, this->GetSampleRate());
+	mDeviceOneLowMax = mMaxSampleCount(mPercent(mDeviceBittimeMax, mADBLowTimeBitCellPctOne + mADBLowTimePctError), 0, this->GetSampleRate());
+	mDeviceOneHighMin = mMinSampleCount(mPercent(mDeviceBittimeMin, (100 - mADBLowTimeBitCellPctOne) - mADBLowTimePctError), 0, this->GetSampleRate());
+	mDeviceOneHighMax = mMaxSampleCount(mPercent(mDeviceBittimeMax, (100 - mADBLowTimeBitCellPctOne) + mADBLowTimePctError), 0, this->GetSampleRate());
+
+	/* Device stop bit low time, scaled with bit cell */
+	mDeviceStopMin = mMinSampleCount(mADBStopTime * dBitCellTime / mADBBitCellTime, uiPctError, this->GetSampleRate());
+	// mDeviceStopMax = mMaxSampleCount(mADBStopTime * dBitCellTime / mADBBitCellTime, uiPctError, this->GetSampleRate());
+}
+
+void ADBAnalyzer::TrackDeviceBitCellTime(U8 byCommand, U64 uiSamples, U32 uiBitCells)
+{
+	U8 uiAddr = ((byCommand >> mADBCommandAddrShift) & mADBCommandAddrMask);
+	double dBitCellTime = SamplesToUs(uiSamples) / uiBitCells;
+
+	/* First response sets estimate, following ones move it a quarter of the way */
+	if (mDeviceBitCellTime[uiAddr] > 0.0) dBitCellTime = ((mDeviceBitCellTime[uiAddr] * 3) + dBitCellTime) / 4;
+	mDeviceBitCellTime[uiAddr] = LimitBitCellTime(dBitCellTime);
+}
+
+double ADBAnalyzer::LimitBitCellTime(double dBitCellTime)
+{
+	double dMin = mSubPercent(double(mADBBitCellTime), mADBAdaptivePctLimit);
+	double dMax = mAddPercent(double(mADBBitCellTime), mADBAdaptivePctLimit);
+
+	if (dBitCellTime < dMin) return dMin;
+	if (dBitCellTime > dMax) return dMax;
+	return dBitCellTime;
+}
+
+std::vector<U64> ADBAnalyzer::GetSampleLimits()
+{
+	U64 auiLimits[] =
+	{
+		mAttentionMin, mAttentionMax,
+		mSyncMin, mSyncMax,
+		mHostZeroLowMin, mHostZeroLowMax,
+		mHostZeroHighMin, mHostZeroHighMax,
+		mHostOneLowMin, mHostOneLowMax,
+		mHostOneHighMin, mHostOneHighMax,
+		mDeviceZeroLowMin, mDeviceZeroLowMax,
+		mDeviceZeroHighMin, mDeviceZeroHighMax,
+		mDeviceOneLowMin, mDeviceOneLowMax,
+		mDeviceOneHighMin, mDeviceOneHighMax,
+		mHostStopMin,
+		mDeviceStopMin,
+		mGlobalReset,
+		mServiceRequestMin, mServiceRequestMax,
+		mADBStopToStartMin, mADBStopToStartMax
+	};
+
+	return std::vector<U64>(auiLimits, auiLimits + (sizeof(auiLimits) / sizeof(auiLimits[0])));
 }
 
 const char* ADBAnalyzer::CmdCodeRegToString(U8 uiCmdCode, U8 uiReg)
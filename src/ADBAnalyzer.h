@@ -13,8 +13,29 @@
 #include "Analyzer.h"
 #include "ADBAnalyzerResults.h"
 #include "ADBSimulationDataGenerator.h"
+#include "ADBEdgeReader.h"
+#include "ADBDecodeLog.h"
+#include "ADBTransactionMatcher.h"
+#include "ADBTransactionStream.h"
+#include "ADBDecodeLag.h"
+
+/* mType values */
+enum ADBFrameType
+{
+	/* Command or data byte */
+	ByteFrame,
+
+	/* Transaction abandoned due to timing (statistics only mode) */
+	TimingViolationFrame,
+
+	/* Global reset (statistics only mode) */
+	GlobalResetFrame,
 
-/* mType bit values */
+	/* Run of transactions carrying a service request (statistics only mode) */
+	ServiceRequestStormFrame
+};
+
+/* mFlags bit values */
 #define DATA_BYTE_FLAG ( 1 << 0 )
 #define SERVICE_REQUEST_FLAG ( 1 << 1 )
 
@@ -92,9 +113,9 @@ class ADBAnalyzer : public Analyzer2
 		/* ADB bitrate */
 		const U32 mADBBitRate = mUSPerSec / mADBBitCellTime;
 
-		/* ADB allowable timing errors for host / device as a percentage of nominal timings */
-		const U32 mADBPctErrorHost = 3; /* +/- percent */
-		const U32 mADBPctErrorDevice = 30; /* +/- percent */
+		/* ADB allowable timing errors for host / device as a percentage of nominal timings (from settings) */
+		U32 mADBPctErrorHost; /* +/- percent */
+		U32 mADBPctErrorDevice; /* +/- percent */
 
 		/*
 		** Bit cell low periods as a percentage of bit cell time for zero and one,
@@ -102,7 +123,7 @@ class ADBAnalyzer : public Analyzer2
 		*/
 		const U32 mADBLowTimeBitCellPctZero = 65; /* percent */
 		const U32 mADBLowTimeBitCellPctOne = 35; /* percent */
-		const U32 mADBLowTimePctError = 5; /* +/- percent */
+		U32 mADBLowTimePctError; /* +/- percent (from settings) */
 
 		/* Host attention pulse time */
 		const U32 mADBAttentionTime = 800; /* us subject to host error */
@@ -119,16 +140,16 @@ class ADBAnalyzer : public Analyzer2
 		/* Service request pulse time */
 		const U32 mADBServiceReqTime = 300; /* us subject to device error */
 
-		/* Stop bit to start bit time */
-		const U32 mADBStopToStartTimeMin = 140; /* us */
-		const U32 mADBStopToStartTimeMax = 260; /* us */
+		/* Stop bit to start bit time (from settings) */
+		U32 mADBStopToStartTimeMin; /* us */
+		U32 mADBStopToStartTimeMax; /* us */
 
 		/* Shared settings and results */
 		std::unique_ptr<ADBAnalyzerSettings> mSettings;
 		std::unique_ptr<ADBAnalyzerResults> mResults;
 
-		/* Source channel */
-		AnalyzerChannelData* mADB;
+		/* Source channel, filtered for glitches */
+		ADBEdgeReader mADB;
 
 		/* Calculated sample counts */
 		U64 mAttentionMin, mAttentionMax;
@@ -147,18 +168,154 @@ class ADBAnalyzer : public Analyzer2
 		U64 mServiceRequestMin, mServiceRequestMax;
 		U64 mADBStopToStartMin, mADBStopToStartMax;
 
+		/* Calculated sample counts, in a fixed order, for comparison between decodes */
+		std::vector<U64> GetSampleLimits();
+
+		/* Calculate device to host bit and stop bit sample counts, for a device with given bit cell time (us) and error */
+		void CalculateDeviceLimits(double dBitCellTime, U32 uiPctError);
+
+		/* Update bit cell time tracked for address of command, from a response of given length */
+		void TrackDeviceBitCellTime(U8 byCommand, U64 uiSamples, U32 uiBitCells);
+
+		/* Limit bit cell time to within allowed percentage of nominal */
+		double LimitBitCellTime(double dBitCellTime);
+
+		/* Convert sample count to microseconds */
+		double SamplesToUs(U64 uiSamples) { return (double(uiSamples) * mUSPerSec) / this->GetSampleRate(); }
+
+		/* Adaptive device timing, windows centred on the bit cell measured from each response's start bit */
+		bool mAdaptiveDeviceTiming;
+
+		/* Bit cell time (us) tracked for each address across responses, zero if unknown */
+		double mDeviceBitCellTime[16];
+
+		/* Low period of response start bit, start of response */
+		U64 mDeviceStartBitLow;
+		U64 mDeviceResponseStart;
+
+		/* Limit tracked bit cell time to within this percentage of nominal, start bit of an unknown device accepted within it */
+		const U32 mADBAdaptivePctLimit = 50;
+
+		/* Smallest distance of any period from a limit it was compared against, within current segment */
+		U64 mSlack;
+
+		/* Record distance of a comparison from changing outcome */
+		void TrackMargin(U64 uiMargin)
+		{
+			if (uiMargin < mSlack) mSlack = uiMargin;
+		}
+
+		/* Check period is at least min */
+		bool AtLeast(U64 uiPeriod, U64 uiMin)
+		{
+			TrackMargin((uiPeriod >= uiMin) ? (uiPeriod - uiMin) : (uiMin - uiPeriod - 1));
+			return (uiPeriod >= uiMin);
+		}
+
+		/* Check period is within min and max (inclusive) */
+		bool InWindow(U64 uiPeriod, U64 uiMin, U64 uiMax)
+		{
+			TrackMargin((uiPeriod <= uiMax) ? (uiMax - uiPeriod) : (uiPeriod - uiMax - 1));
+			return AtLeast(uiPeriod, uiMin) && (uiPeriod <= uiMax);
+		}
+
 		/* Read byte from stream */
 		bool ReadByte(bool bHostToDevice, U8 *pbyOutput);
 
+		/* Count transaction abandoned in given state, output it in statistics only mode */
+		void OutputTimingViolation(ADBState eState, U64 uiStart, U64 uiEnd);
+
+		/* Count global reset, output it in statistics only mode */
+		void OutputGlobalReset(U64 uiStart, U64 uiEnd);
+
+		/* Output frame for an exceptional event in statistics only mode */
+		void OutputEventFrame(ADBFrameType eType, const char* pszType, U64 uiStart, U64 uiEnd, const char* pszDetail);
+
+		/* Convert state to string */
+		static const char* StateToString(ADBState eState);
+
+		/* Add marker to input channel */
+		void AddMarker(U64 uiSample, AnalyzerResults::MarkerType eType);
+
+		/* Start new packet, discarding anything uncommitted */
+		void StartPacket();
+
+		/* Add byte frame to results, tracking frames covered by packet */
+		void AddByteFrame(const Frame& frame);
+
+		/* Discard markers and frames held back for transaction in progress */
+		void DiscardStaged();
+
+		/* Add marker to results, if wanted at current verbosity */
+		void OutputMarker(U64 uiSample, AnalyzerResults::MarkerType eType);
+
+		/* Output markers held back for transaction in progress */
+		void OutputStagedMarkers();
+
 		/* Output byte for display on waveform / export */
 		void OutputByteForDisplayAndExport(bool bIsData, bool bServiceRequested, U8 byData, U64 uiStart, U64 uiEnd);
 
-		/* Output bytes for display in table */
-		void OutputBytesForTable(U8 byCommand, U8 *pabyData, U8 uiDataLen, bool bServiceRequested, U64 uiStart, U64 uiEnd);
+		/* Output bytes for display in table, attention is where the transaction began */
+		void OutputBytesForTable(U8 byCommand, U8 *pabyData, U8 uiDataLen, bool bServiceRequested, U64 uiAttention, U64 uiStart, U64 uiEnd);
+
+		/* Replay segments of previous decode starting at current location, returns true if any were */
+		bool ReplaySegments();
+
+		/* Close current segment at a transaction boundary */
+		void EndSegment();
+
+		/* Log of current decode, log of previous decode being reused */
+		ADBDecodeLog mDecodeLog;
+		ADBDecodeLog mPrevDecodeLog;
+
+		/* Largest change in limits since the previous decode */
+		U64 mLimitChange;
+
+		/* Next segment of previous decode which may be reused, and number reused */
+		size_t mReplaySegment;
+		size_t mReplayedSegments;
+
+		/* Current segment of this decode */
+		ADBDecodeSegment mSegment;
+		bool mSegmentFirstEdgePending;
+
+		/* Transaction committed since segment started */
+		bool mSegmentCommitted;
+
+		/* Only keep statistics, outputting exceptional events */
+		bool mStatisticsOnly;
+
+		/* Location of attention pulse of current transaction */
+		U64 mTransactionStart;
+
+		/* Transaction patterns, only output matching transactions */
+		ADBTransactionMatcher mMatcher;
+		bool mMatchesOnly;
+
+		/* Marker verbosity, only mark transactions which fail or carry a service request */
+		U32 mMarkerVerbosity;
+		bool mMarkFailedOrServiceRequestOnly;
+
+		/* Markers and frames of transaction in progress, held back until it's known to match / fail / carry a service request */
+		bool mStagingMarkers;
+		bool mStagingFrames;
+		std::vector<std::pair<U64, AnalyzerResults::MarkerType>> mStagedMarkers;
+		std::vector<Frame> mStagedFrames;
+		static const size_t mStagedMarkersReserve = 256;
+
+		/* Live stream of completed transactions */
+		ADBTransactionStream mStream;
+
+		/* Lag of decoding behind a streaming capture */
+		ADBDecodeLag mDecodeLag;
 
 		/* Packet id/index */
 		U64 mPacketID;
 
+		/* First (command) and last frame of current packet */
+		U64 mPacketFirstFrame;
+		U64 mPacketLastFrame;
+
 		/* Simulation state */
 		bool mSimulationInitialised;
 		ADBSimulationDataGenerator mSimulationDataGenerator;
@@ -3,11 +3,21 @@
 #include <AnalyzerHelpers.h>
 #include "ADBAnalyzer.h"
 #include "ADBAnalyzerSettings.h"
+#include "ADBPayloadDecoder.h"
+#include "ADBExportCompressor.h"
+#include "ADBTransactionStream.h"
 #include <iostream>
 #include <sstream>
+#include <algorithm>
+#include <iterator>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
 
 ADBAnalyzerResults::ADBAnalyzerResults(ADBAnalyzer* analyzer, ADBAnalyzerSettings* settings)
-	: AnalyzerResults(), mSettings(settings), mAnalyzer(analyzer)
+	: AnalyzerResults(), mSettings(settings), mAnalyzer(analyzer), mStringCache(mStringCacheSize)
 {
 }
 
@@ -17,49 +27,510 @@ ADBAnalyzerResults::~ADBAnalyzerResults()
 
 void ADBAnalyzerResults::GenerateBubbleText(U64 frame_index, Channel& /*channel*/, DisplayBase display_base)
 {
-	Frame frame = GetFrame(frame_index);
 	ClearResultStrings();
 
-	char number_str[128];
-	AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 8, number_str, 128);
-	AddResultString(number_str);
+	/*
+	** Bubble strings are cached together, separated by line breaks, so a hit needs no frame or packet lookup.
+	** Those of a frame whose packet isn't committed yet lack the payload, so aren't cached until it is.
+	*/
+	std::string str;
+	if (!mStringCache.Lookup(BubbleString, frame_index, display_base, str))
+	{
+		bool complete;
+		str = FormatBubble(frame_index, display_base, &complete);
+		if (complete) mStringCache.Insert(BubbleString, frame_index, display_base, str);
+	}
+
+	size_t start = 0;
+	for (;;)
+	{
+		size_t end = str.find('\n', start);
+		AddResultString(str.substr(start, end - start).c_str());
+		if (std::string::npos == end) break;
+		start = end + 1;
+	}
 }
 
-void ADBAnalyzerResults::GenerateExportFile(const char* file, DisplayBase display_base, U32 /*export_type_user_id*/)
+void ADBAnalyzerResults::GenerateExportFile(const char* file, DisplayBase display_base, U32 export_type_user_id)
 {
-	std::stringstream ss;
+	/* Assume whole capture is to be exported */
+	U64 first_frame = 0;
+	U64 end_frame = GetNumFrames();
+
+	if (ExportCsvTimeWindow == export_type_user_id)
+	{
+		/* Convert window to sample numbers and locate packets within it */
+		U64 trigger_sample = mAnalyzer->GetTriggerSample();
+		U32 sample_rate = mAnalyzer->GetSampleRate();
+		U64 start_sample = TimeToSample(mSettings->mExportWindowStart.c_str(), trigger_sample, sample_rate, 0);
+		U64 end_sample = TimeToSample(mSettings->mExportWindowEnd.c_str(), trigger_sample, sample_rate, UINT64_MAX);
+
+		if (!GetFramesInSampleRange(start_sample, end_sample, &first_frame, &end_frame))
+		{
+			/* Nothing in window, output header only */
+			first_frame = end_frame = 0;
+		}
+	}
+
 	void* f = AnalyzerHelpers::StartFile(file);
+	if (ExportStatistics == export_type_user_id)
+	{
+		ExportStatisticsFile(f, display_base);
+	}
+	else if (ExportAnalytics == export_type_user_id)
+	{
+		ExportAnalyticsFile(f, display_base);
+	}
+	else if (ExportRegisterTimeline == export_type_user_id)
+	{
+		ExportRegisterTimelineFile(f, display_base);
+	}
+	else if (ExportTrace == export_type_user_id)
+	{
+		ExportTraceFile(f);
+	}
+#ifdef ADB_HAVE_ZLIB
+	else if (ExportCsvCompressed == export_type_user_id)
+	{
+		/* Compressor is finished even if cancelled, so what was written is a complete stream */
+		ADBExportCompressor compressor;
+		bool compressed = compressor.Start(f);
+		if (compressed)
+		{
+			ExportFrames(f, display_base, first_frame, end_frame, &compressor);
+			compressed = compressor.Finish();
+		}
+
+		if (!compressed)
+		{
+			/* Compression failed, drop the broken file and export plain CSV alongside, named as such */
+			AnalyzerHelpers::EndFile(f);
+			remove(file);
+			f = AnalyzerHelpers::StartFile(UncompressedExportPath(file).c_str());
+			ExportFrames(f, display_base, first_frame, end_frame, NULL);
+		}
+	}
+#endif
+	else
+	{
+		ExportFrames(f, display_base, first_frame, end_frame, NULL);
+	}
+	AnalyzerHelpers::EndFile(f);
+}
+
+std::string ADBAnalyzerResults::UncompressedExportPath(const char* file)
+{
+	/* Strip .gz, leaving any extension before it (export.csv.gz gives export.csv) or adding .csv */
+	std::string path(file);
+	if ((path.size() > 3) && (0 == path.compare(path.size() - 3, 3, ".gz"))) path.erase(path.size() - 3);
+
+	size_t slash = path.find_last_of("/\\");
+	size_t dot = path.find_last_of('.');
+	if ((std::string::npos == dot) || ((std::string::npos != slash) && (dot < slash))) path += ".csv";
+
+	return path;
+}
+
+void ADBAnalyzerResults::ExportStatisticsFile(void* f, DisplayBase display_base)
+{
+	std::stringstream ss;
+
+	ADBStatisticsData data;
+	mStatistics.GetSnapshot(&data);
 
+	/* Summary */
+	ss << "Statistic,Count" << std::endl;
+	ss << "Transactions," << data.uiTransactions << std::endl;
+	ss << "Data bytes," << data.uiDataBytes << std::endl;
+	ss << "Service requests," << data.uiServiceRequests << std::endl;
+	ss << "Service request storms," << data.uiServiceRequestStorms << std::endl;
+	ss << "Timing violations," << data.uiTimingViolations << std::endl;
+	ss << "Global resets," << data.uiGlobalResets << std::endl;
+	ss << std::endl;
+
+	/* Per device summary */
 	U64 trigger_sample = mAnalyzer->GetTriggerSample();
 	U32 sample_rate = mAnalyzer->GetSampleRate();
-	U64 num_frames = GetNumFrames();
-	U64 last_packet_id = UINT64_MAX;
 
-	ss << "Time [s],Addr,Cmd,Reg,Data0,Data1,Data2,Data3,Data4,Data5,Data6,Data7,SvcReq" << std::endl;
+	ss << "Addr,Talk,Listen,Flush,Send reset,Reserved,Talk responses,Talk timeouts,Response rate (%),Data bytes,Service requests,First activity [s],Last activity [s]" << std::endl;
+	for (U8 addr = 0; addr < ADB_NUM_ADDRESSES; addr++)
+	{
+		/* Command mix, from counts of the address's command bytes */
+		U64 auiCommands[5] = {0, 0, 0, 0, 0};
+		for (U32 code = 0; code <= ADBAnalyzer::mADBCommandCodeMask; code++)
+		{
+			for (U32 reg = 0; reg <= ADBAnalyzer::mADBCommandRegMask; reg++)
+			{
+				U8 command = U8((addr << ADBAnalyzer::mADBCommandAddrShift) | (code << ADBAnalyzer::mADBCommandCodeShift) | (reg << ADBAnalyzer::mADBCommandRegShift));
+				U64 count = data.auiCommandCounts[command];
+
+				if (Talk == code) auiCommands[0] += count;
+				else if (Listen == code) auiCommands[1] += count;
+				else if ((SendResetOrFlush == code) && (1 == reg)) auiCommands[2] += count;
+				else if ((SendResetOrFlush == code) && (0 == reg)) auiCommands[3] += count;
+				else auiCommands[4] += count;
+			}
+		}
+		if (0 == (auiCommands[0] + auiCommands[1] + auiCommands[2] + auiCommands[3] + auiCommands[4])) continue;
+
+		const ADBDeviceStatistics& device = data.aDevices[addr];
+
+		char number_str[ 128 ];
+		AnalyzerHelpers::GetNumberString(addr, display_base, 8, number_str, 128);
+		ss << number_str;
+		for (U32 i = 0; i < 5; i++) ss << "," << auiCommands[i];
+		ss << "," << device.uiTalkResponses << "," << (auiCommands[0] - device.uiTalkResponses);
+
+		/* Response rate to a tenth of a percent, empty if never talked to */
+		ss << ",";
+		if (auiCommands[0] > 0)
+		{
+			U64 tenths = (device.uiTalkResponses * 1000) / auiCommands[0];
+			ss << (tenths / 10) << "." << (tenths % 10);
+		}
+
+		ss << "," << device.uiDataBytes;
+		ss << "," << device.uiServiceRequests;
+
+		char time_str[ 128 ];
+		AnalyzerHelpers::GetTimeString(device.uiFirstActivity, trigger_sample, sample_rate, time_str, 128);
+		ss << "," << time_str;
+		AnalyzerHelpers::GetTimeString(device.uiLastActivity, trigger_sample, sample_rate, time_str, 128);
+		ss << "," << time_str << std::endl;
+	}
+	ss << std::endl;
+
+	/* Commands seen */
+	ss << "Addr,Cmd,Reg,Count" << std::endl;
+	for (U32 command = 0; command < 256; command++)
+	{
+		if (0 == data.auiCommandCounts[command]) continue;
+
+		U8 uiAddr = ((command >> ADBAnalyzer::mADBCommandAddrShift) & ADBAnalyzer::mADBCommandAddrMask);
+		ADBCommand eCode = ADBCommand((command >> ADBAnalyzer::mADBCommandCodeShift) & ADBAnalyzer::mADBCommandCodeMask);
+		U8 uiReg = ((command >> ADBAnalyzer::mADBCommandRegShift) & ADBAnalyzer::mADBCommandRegMask);
+
+		char number_str[ 128 ];
+		AnalyzerHelpers::GetNumberString(uiAddr, display_base, 8, number_str, 128);
+		ss << number_str;
+		ss << "," << ADBAnalyzer::CmdCodeRegToString(eCode, uiReg);
+		AnalyzerHelpers::GetNumberString(uiReg, display_base, 8, number_str, 128);
+		ss << "," << number_str;
+		ss << "," << data.auiCommandCounts[command] << std::endl;
+	}
+
+	AnalyzerHelpers::AppendToFile((U8*)ss.str().c_str(), ss.str().length(), f);
+
+	UpdateExportProgressAndCheckForCancel(1, 1);
+}
+
+void ADBAnalyzerResults::ExportAnalyticsFile(void* f, DisplayBase display_base)
+{
+	std::stringstream ss;
+
+	/* Histograms are large, snapshot on the heap */
+	std::unique_ptr<ADBBusAnalyticsData> data(new ADBBusAnalyticsData);
+	mAnalytics.GetSnapshot(data.get());
+
+	/* Label each address in display base */
+	char address_str[ADB_NUM_ADDRESSES][ 128 ];
+	for (U32 i = 0; i < ADB_NUM_ADDRESSES; i++)
+	{
+		AnalyzerHelpers::GetNumberString(i, display_base, 8, address_str[i], 128);
+	}
+
+	std::stringstream utilization_ss;
+	utilization_ss << "Utilization per " << mAnalytics.GetWindowMs() << " ms (%)";
+	std::string utilization_str = utilization_ss.str();
+
+	/* Summary */
+	ss << "Metric,Addr,Count,Min,Mean,P50,P90,P99,Max" << std::endl;
+	OutputHistogramSummary(ss, utilization_str.c_str(), "", data->cUtilization);
+	for (U32 i = 0; i < ADB_NUM_ADDRESSES; i++)
+	{
+		OutputHistogramSummary(ss, "Poll interval (us)", address_str[i], data->acPollInterval[i]);
+	}
+	OutputHistogramSummary(ss, "SRQ latency (us)", "", data->cServiceRequestLatency);
+	for (U32 i = 0; i < ADB_NUM_ADDRESSES; i++)
+	{
+		OutputHistogramSummary(ss, "SRQ latency (us)", address_str[i], data->acServiceRequestLatency[i]);
+	}
+	ss << std::endl;
+
+	/* Histograms */
+	ss << "Metric,Addr,Low,High,Count" << std::endl;
+	OutputHistogramBuckets(ss, utilization_str.c_str(), "", data->cUtilization);
+	for (U32 i = 0; i < ADB_NUM_ADDRESSES; i++)
+	{
+		OutputHistogramBuckets(ss, "Poll interval (us)", address_str[i], data->acPollInterval[i]);
+	}
+	OutputHistogramBuckets(ss, "SRQ latency (us)", "", data->cServiceRequestLatency);
+	for (U32 i = 0; i < ADB_NUM_ADDRESSES; i++)
+	{
+		OutputHistogramBuckets(ss, "SRQ latency (us)", address_str[i], data->acServiceRequestLatency[i]);
+	}
+
+	AnalyzerHelpers::AppendToFile((U8*)ss.str().c_str(), ss.str().length(), f);
+
+	UpdateExportProgressAndCheckForCancel(1, 1);
+}
+
+void ADBAnalyzerResults::ExportRegisterTimelineFile(void* f, DisplayBase display_base)
+{
+	std::stringstream ss;
+
+	/* Window, whole capture if not set */
+	U64 trigger_sample = mAnalyzer->GetTriggerSample();
+	U32 sample_rate = mAnalyzer->GetSampleRate();
+	U64 start_sample = TimeToSample(mSettings->mExportWindowStart.c_str(), trigger_sample, sample_rate, 0);
+	U64 end_sample = TimeToSample(mSettings->mExportWindowEnd.c_str(), trigger_sample, sample_rate, UINT64_MAX);
+
+	ss << "Time [s],Addr,Reg,Cmd,Data" << std::endl;
+
+	std::vector<ADBRegisterChange> changes;
+	for (U8 addr = 0; addr < ADB_NUM_ADDRESSES; addr++)
+	{
+		for (U8 reg = 0; reg < ADB_NUM_REGISTERS; reg++)
+		{
+			/* Value in effect at start of window */
+			ADBRegisterChange change;
+			if (mRegisterTimeline.GetValueAt(addr, reg, start_sample, &change))
+			{
+				OutputRegisterChange(ss, display_base, trigger_sample, sample_rate, addr, reg, change);
+			}
+
+			/* Changes within window */
+			mRegisterTimeline.GetChanges(addr, reg, &changes);
+			for (size_t i = 0; i < changes.size(); i++)
+			{
+				if (changes[i].uiSample <= start_sample) continue;
+				if (changes[i].uiSample > end_sample) break;
+
+				OutputRegisterChange(ss, display_base, trigger_sample, sample_rate, addr, reg, changes[i]);
+			}
+		}
+	}
+
+	AnalyzerHelpers::AppendToFile((U8*)ss.str().c_str(), ss.str().length(), f);
+
+	UpdateExportProgressAndCheckForCancel(1, 1);
+}
+
+void ADBAnalyzerResults::OutputRegisterChange(std::stringstream& ss, DisplayBase display_base, U64 trigger_sample, U32 sample_rate, U8 addr, U8 reg, const ADBRegisterChange& change)
+{
+	char time_str[ 128 ];
+	AnalyzerHelpers::GetTimeString(change.uiSample, trigger_sample, sample_rate, time_str, 128);
+	ss << time_str;
+
+	char number_str[ 128 ];
+	AnalyzerHelpers::GetNumberString(addr, display_base, 8, number_str, 128);
+	ss << "," << number_str;
+	AnalyzerHelpers::GetNumberString(reg, display_base, 8, number_str, 128);
+	ss << "," << number_str;
+	ss << "," << (change.bListen ? "listen" : "talk") << ",";
+
+	for (U8 i = 0; i < change.uiDataLen; i++)
+	{
+		AnalyzerHelpers::GetNumberString(change.abyData[i], display_base, 8, number_str, 128);
+		if (i > 0) ss << " ";
+		ss << number_str;
+	}
+	ss << std::endl;
+}
+
+void ADBAnalyzerResults::OutputHistogramSummary(std::stringstream& ss, const char* metric, const char* address, const ADBHistogram& histogram)
+{
+	/* Skip anything not seen */
+	if (0 == histogram.GetCount()) return;
+
+	ss << metric << "," << address << "," << histogram.GetCount();
+	ss << "," << histogram.GetMin() << "," << U64(histogram.GetMean() + 0.5);
+	ss << "," << histogram.GetPercentile(50.0) << "," << histogram.GetPercentile(90.0) << "," << histogram.GetPercentile(99.0);
+	ss << "," << histogram.GetMax() << std::endl;
+}
+
+void ADBAnalyzerResults::OutputHistogramBuckets(std::stringstream& ss, const char* metric, const char* address, const ADBHistogram& histogram)
+{
+	for (U32 i = 0; i < ADBHistogram::mNumBuckets; i++)
+	{
+		U64 count = histogram.GetBucketCount(i);
+		if (0 == count) continue;
+
+		/* Open ended last bucket is shown up to the largest value seen */
+		U64 high = ADBHistogram::GetBucketHigh(i);
+		if (i == (ADBHistogram::mNumBuckets - 1)) high = histogram.GetMax();
+
+		ss << metric << "," << address << "," << ADBHistogram::GetBucketLow(i) << "," << high << "," << count << std::endl;
+	}
+}
+
+void ADBAnalyzerResults::ExportTraceFile(void* f)
+{
+	U32 sample_rate = mAnalyzer->GetSampleRate();
+	std::vector<U8> records(size_t(mTraceRecordsPerWrite) * ADBTransactionStream::mRecordSize);
+	std::vector<PacketIndexEntry> entries;
+	entries.reserve(mTraceRecordsPerWrite);
+
+	size_t num_packets;
+	{
+		std::lock_guard<std::mutex> lock(mPacketIndexMutex);
+		num_packets = mPacketIndex.size();
+	}
+
+	for (size_t first = 0; first < num_packets; first += entries.size())
+	{
+		/* Copy a batch of the index, so it isn't held locked while frames are read */
+		{
+			std::lock_guard<std::mutex> lock(mPacketIndexMutex);
+			size_t count = std::min<size_t>(num_packets - first, mTraceRecordsPerWrite);
+			entries.assign(mPacketIndex.begin() + first, mPacketIndex.begin() + first + count);
+		}
+
+		/* Sequence numbers count packets from the start of the capture, nothing is dropped, a single generation */
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			U8 command;
+			U8 data[8];
+			U8 data_len;
+			bool service_request;
+			ReadPacketFrames(entries[i].uiFirstFrame, entries[i].uiLastFrame, &command, data, &data_len, &service_request);
+
+			ADBTransactionStream::EncodeRecord(&records[i * ADBTransactionStream::mRecordSize], 0, U32(first + i), 0, sample_rate,
+											   command, data, data_len, service_request, entries[i].uiAttentionSample, entries[i].uiEndSample);
+		}
+
+		AnalyzerHelpers::AppendToFile(&records[0], U32(entries.size() * ADBTransactionStream::mRecordSize), f);
+		if (UpdateExportProgressAndCheckForCancel(first + entries.size(), num_packets) == true) return;
+	}
+
+	/* Final check */
+	UpdateExportProgressAndCheckForCancel(num_packets, num_packets);
+}
+
+void ADBAnalyzerResults::ExportFrames(void* f, DisplayBase display_base, U64 first_frame, U64 end_frame, ADBExportCompressor* compressor)
+{
+	U64 num_frames = end_frame - first_frame;
+
+	/* Header */
+	std::string header("Time [s],Addr,Cmd,Reg,Data0,Data1,Data2,Data3,Data4,Data5,Data6,Data7,SvcReq");
+	if (mSettings->mDecodePayloads) header += ",Decoded";
+	header += "\n";
+	WriteExportOutput(f, header, compressor);
+
+	/* Chunk per thread in flight, frames and buffers are reused for each batch */
+	U32 num_threads = std::thread::hardware_concurrency();
+	if (num_threads < 1) num_threads = 1;
+	if (num_threads > mMaxExportThreads) num_threads = mMaxExportThreads;
+	mExportPool.Start(num_threads - 1);
+	std::vector<std::vector<Frame>> frames(num_threads);
+	std::vector<std::string> buffers(num_threads);
+	std::vector<U64> bounds(num_threads + 1);
+
+	U64 trigger_sample = mAnalyzer->GetTriggerSample();
+	U32 sample_rate = mAnalyzer->GetSampleRate();
+
+	U64 chunk_start = first_frame;
+	while (chunk_start < end_frame)
+	{
+		/* Split next batch into chunks, each starting at a new packet */
+		U32 num_chunks = 0;
+		bounds[0] = chunk_start;
+		while ((num_chunks < num_threads) && (bounds[num_chunks] < end_frame))
+		{
+			U64 chunk_end = bounds[num_chunks] + mExportChunkFrames;
+			bounds[num_chunks + 1] = (chunk_end < end_frame) ? FindPacketStart(chunk_end, end_frame) : end_frame;
+			num_chunks++;
+		}
+
+		/* Frames are only ever read on this thread, as the worker thread may still be adding them */
+		for (U32 i = 0; i < num_chunks; i++)
+		{
+			frames[i].clear();
+			for (U64 j = bounds[i]; j < bounds[i + 1]; j++) frames[i].push_back(GetFrame(j));
+		}
+
+		/* Format copies in parallel */
+		mExportPool.Run(num_chunks, [&](U32 i) { FormatFrames(buffers[i], display_base, trigger_sample, sample_rate, frames[i]); });
+
+		/* Output in order, stopping early if cancelled */
+		for (U32 i = 0; i < num_chunks; i++)
+		{
+			WriteExportOutput(f, buffers[i], compressor);
+			if (UpdateExportProgressAndCheckForCancel(bounds[i + 1] - first_frame, num_frames) == true) return;
+		}
+
+		chunk_start = bounds[num_chunks];
+	}
+
+	/* Final check */
+	UpdateExportProgressAndCheckForCancel(num_frames, num_frames);
+}
+
+void ADBAnalyzerResults::WriteExportOutput(void* f, std::string& output, ADBExportCompressor* compressor)
+{
+#ifdef ADB_HAVE_ZLIB
+	if (NULL != compressor)
+	{
+		/* Compressor takes the output, handing back an emptied buffer to reuse */
+		compressor->Write(output);
+		return;
+	}
+#else
+	(void)compressor;
+#endif
+	AnalyzerHelpers::AppendToFile((U8*)output.c_str(), U32(output.size()), f);
+}
+
+U64 ADBAnalyzerResults::FindPacketStart(U64 frame_index, U64 end_frame)
+{
+	U64 packet_id = GetFrame(frame_index - 1).mData2;
+	while ((frame_index < end_frame) && (GetFrame(frame_index).mData2 == packet_id)) frame_index++;
+
+	return frame_index;
+}
+
+void ADBAnalyzerResults::FormatFrames(std::string& buffer, DisplayBase display_base, U64 trigger_sample, U32 sample_rate, const std::vector<Frame>& frames)
+{
+	buffer.clear();
+
+	U64 last_packet_id = UINT64_MAX;
 
 	/* Reset data count, such that we always output 8 bytes */
 	U8 data_count = 0;
 
+	/* Command and data of current packet, retained for payload decoding */
+	U8 command = 0;
+	U8 data[8];
+
 	/* Assume neither command nor data contains a service request */
 	bool service_request = false;
 
-	for (U32 i = 0; i < num_frames; i++)
+	/* Packet line started but not yet ended */
+	bool line_open = false;
+
+	for (size_t i = 0; i < frames.size(); i++)
 	{
-		Frame frame = GetFrame(i);
+		const Frame& frame = frames[i];
+
+		/* Only bytes are exported, events of statistics only mode are skipped */
+		if (ByteFrame != frame.mType)
+		{
+			continue;
+		}
 
 		if (last_packet_id != frame.mData2)
 		{
 			/* Start of new packet, output empty columns, final service request status and end line */
-			if (i > 0)
+			if (line_open)
 			{
-				for (int j = data_count; j < 8; j++) ss << ",";
-				ss << "," << service_request << std::endl;
+				OutputLineEnd(buffer, command, data, data_count, service_request);
 			}
+			line_open = true;
 
 			/* Output time string */
 			char time_str[ 128 ];
 			AnalyzerHelpers::GetTimeString(frame.mStartingSampleInclusive, trigger_sample, sample_rate, time_str, 128);
-			ss << time_str;
+			buffer += time_str;
 
 			/* Decode command */
 			U8 uiAddr = ((frame.mData1 >> ADBAnalyzer::mADBCommandAddrShift) & ADBAnalyzer::mADBCommandAddrMask);
@@ -69,13 +540,17 @@ void ADBAnalyzerResults::GenerateExportFile(const char* file, DisplayBase displa
 			/* Output command byte fields */
 			char number_str[ 128 ];
 			AnalyzerHelpers::GetNumberString(uiAddr, display_base, 8, number_str, 128);
-			ss << "," << number_str;
-			ss << "," << ADBAnalyzer::CmdCodeRegToString(eCode, uiReg);
+			buffer += ",";
+			buffer += number_str;
+			buffer += ",";
+			buffer += ADBAnalyzer::CmdCodeRegToString(eCode, uiReg);
 			AnalyzerHelpers::GetNumberString(uiReg, display_base, 8, number_str, 128);
-			ss << "," << number_str;
+			buffer += ",";
+			buffer += number_str;
 
 			/* Reset data count */
 			data_count = 0;
+			command = U8(frame.mData1);
 
 			/* Reset service request flag */
 			service_request = false;
@@ -89,54 +564,288 @@ void ADBAnalyzerResults::GenerateExportFile(const char* file, DisplayBase displa
 			/* Output data byte */
 			char number_str[ 128 ];
 			AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 8, number_str, 128);
-			ss << "," << number_str;
+			buffer += ",";
+			buffer += number_str;
 
 			/* Count byte */
+			if (data_count < 8) data[data_count] = U8(frame.mData1);
 			data_count++;
 		}
 
 		/* Or in service request status */
 		service_request |= (0 != (frame.mFlags & SERVICE_REQUEST_FLAG));
+	}
 
-		/* Ensure final empty columns, service request status and end line is output on last frame */
-		if (i == (num_frames - 1))
-		{
-			for (int j = data_count; j < 8; j++) ss << ",";
-			ss << "," << service_request << std::endl;
-		}
+	/* Ensure final empty columns, service request status and end line is output */
+	if (line_open)
+	{
+		OutputLineEnd(buffer, command, data, data_count, service_request);
+	}
+}
 
-		/* Output to file and reset buffer */
-		AnalyzerHelpers::AppendToFile((U8*)ss.str().c_str(), ss.str().length(), f);
-		ss.str(std::string());
+void ADBAnalyzerResults::OutputLineEnd(std::string& buffer, U8 command, const U8 *data, U8 data_count, bool service_request)
+{
+	for (int j = data_count; j < 8; j++) buffer += ",";
+	buffer += service_request ? ",1" : ",0";
 
-		/* Stop early if cancelled */
-		if(UpdateExportProgressAndCheckForCancel(i, num_frames) == true)
-		{
-			AnalyzerHelpers::EndFile(f);
-			return;
-		}
+	if (mSettings->mDecodePayloads)
+	{
+		char payload_str[ 128 ];
+		ADBPayloadDecoder::Decode(command, data, data_count, payload_str, sizeof(payload_str));
+		buffer += ",";
+		OutputCsvField(buffer, payload_str);
 	}
 
-	/* Final check */
-	UpdateExportProgressAndCheckForCancel(num_frames, num_frames);
-	AnalyzerHelpers::EndFile(f);
+	buffer += "\n";
+}
+
+void ADBAnalyzerResults::OutputCsvField(std::string& buffer, const char* field)
+{
+	/* Quote fields holding a separator, quote or line break, doubling any quotes (RFC 4180) */
+	if (NULL == strpbrk(field, ",\"\r\n"))
+	{
+		buffer += field;
+		return;
+	}
+
+	buffer += '"';
+	for (const char* c = field; '\0' != *c; c++)
+	{
+		if ('"' == *c) buffer += '"';
+		buffer += *c;
+	}
+	buffer += '"';
+}
+
+void ADBAnalyzerResults::AddPacketToIndex(U64 attention_sample, U64 start_sample, U64 end_sample, U64 first_frame, U64 last_frame)
+{
+	PacketIndexEntry entry = {attention_sample, start_sample, end_sample, first_frame, last_frame};
+
+	std::lock_guard<std::mutex> lock(mPacketIndexMutex);
+	mPacketIndex.push_back(entry);
+}
+
+bool ADBAnalyzerResults::GetFramesInSampleRange(U64 start_sample, U64 end_sample, U64 *first_frame, U64 *end_frame)
+{
+	std::lock_guard<std::mutex> lock(mPacketIndexMutex);
+
+	/* Packets are indexed in decode order, hence sorted by start sample */
+	auto first = std::lower_bound(mPacketIndex.begin(), mPacketIndex.end(), start_sample,
+								  [](const PacketIndexEntry& entry, U64 sample) { return entry.uiStartSample < sample; });
+	auto last = std::upper_bound(first, mPacketIndex.end(), end_sample,
+								 [](U64 sample, const PacketIndexEntry& entry) { return sample < entry.uiStartSample; });
+
+	if (first == last)
+	{
+		/* No packet starts within range */
+		return false;
+	}
+
+	*first_frame = first->uiFirstFrame;
+	*end_frame = std::prev(last)->uiLastFrame + 1;
+
+	return true;
+}
+
+U64 ADBAnalyzerResults::TimeToSample(const char* time_str, U64 trigger_sample, U32 sample_rate, U64 default_sample)
+{
+	/* Empty time leaves that end of the window open */
+	if ('\0' == time_str[0]) return default_sample;
+
+	/* Times are relative to the trigger, as in the export */
+	double sample = double(trigger_sample) + (atof(time_str) * sample_rate);
+	if (sample <= 0.0) return 0;
+	if (sample >= double(UINT64_MAX)) return UINT64_MAX;
+
+	return U64(sample);
 }
 
 void ADBAnalyzerResults::GenerateFrameTabularText(U64 frame_index, DisplayBase display_base)
 {
 	ClearTabularText();
 
-	Frame frame = GetFrame(frame_index);
+	std::string str;
+	if (!mStringCache.Lookup(FrameTabularString, frame_index, display_base, str))
+	{
+		str = FormatFrameByte(GetFrame(frame_index), display_base);
+		mStringCache.Insert(FrameTabularString, frame_index, display_base, str);
+	}
+	AddTabularText(str.c_str());
+}
+
+void ADBAnalyzerResults::GeneratePacketTabularText(U64 packet_id, DisplayBase display_base)
+{
+	ClearTabularText();
+
+	std::string str;
+	if (!mStringCache.Lookup(PacketTabularString, packet_id, display_base, str))
+	{
+		str = FormatPacket(packet_id, display_base);
+		if (mSettings->mDecodePayloads)
+		{
+			std::string payload = FormatPayload(packet_id, display_base);
+			if (!payload.empty()) str += ": " + payload;
+		}
+		mStringCache.Insert(PacketTabularString, packet_id, display_base, str);
+	}
+	AddTabularText(str.c_str());
+}
+
+void ADBAnalyzerResults::GenerateTransactionTabularText(U64 /*transaction_id*/, DisplayBase /*display_base*/)
+{
+}
+
+bool ADBAnalyzerResults::DescribeEventFrame(const Frame& frame, const char** short_str, const char** long_str)
+{
+	switch (frame.mType)
+	{
+		case TimingViolationFrame: *short_str = "Error"; *long_str = "Timing violation"; return true;
+		case GlobalResetFrame: *short_str = "Reset"; *long_str = "Global reset"; return true;
+		case ServiceRequestStormFrame: *short_str = "Storm"; *long_str = "Service request storm"; return true;
+		default: return false;
+	}
+}
+
+std::string ADBAnalyzerResults::FormatFrameByte(const Frame& frame, DisplayBase display_base)
+{
+	/* Events of statistics only mode carry no byte */
+	const char* short_str;
+	const char* long_str;
+	if (DescribeEventFrame(frame, &short_str, &long_str)) return long_str;
 
 	char number_str[ 128 ];
 	AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 8, number_str, 128);
-	AddTabularText(number_str);
+
+	return number_str;
 }
 
-void ADBAnalyzerResults::GeneratePacketTabularText(U64 /*packet_id*/, DisplayBase /*display_base*/)
+std::string ADBAnalyzerResults::FormatBubble(U64 frame_index, DisplayBase display_base, bool* complete)
 {
+	Frame frame = GetFrame(frame_index);
+	*complete = true;
+
+	/* Events of statistics only mode, short and long descriptions */
+	const char* short_str;
+	const char* long_str;
+	if (DescribeEventFrame(frame, &short_str, &long_str))
+	{
+		return std::string(short_str) + "\n" + long_str;
+	}
+
+	std::string byte_str = FormatFrameByte(frame, display_base);
+	std::string str = byte_str;
+
+	if (mSettings->mDecodePayloads && !(frame.mFlags & DATA_BYTE_FLAG))
+	{
+		/* Offer description of the payload as a longer alternative on the command byte */
+		U64 packet_id = GetPacketContainingFrameSequential(frame_index);
+		if (INVALID_RESULT_INDEX == packet_id)
+		{
+			*complete = false;
+		}
+		else
+		{
+			std::string payload = FormatPayload(packet_id, display_base);
+			if (!payload.empty())
+			{
+				str += "\n" + byte_str + " " + payload;
+			}
+		}
+	}
+
+	return str;
 }
 
-void ADBAnalyzerResults::GenerateTransactionTabularText(U64 /*transaction_id*/, DisplayBase /*display_base*/)
+std::string ADBAnalyzerResults::FormatPacket(U64 packet_id, DisplayBase display_base)
 {
+	std::stringstream ss;
+	char number_str[ 128 ];
+
+	U8 command;
+	U8 data[8];
+	U8 data_len;
+	bool service_request;
+	ReadPacket(packet_id, &command, data, &data_len, &service_request);
+
+	/* Decode command */
+	U8 uiAddr = ((command >> ADBAnalyzer::mADBCommandAddrShift) & ADBAnalyzer::mADBCommandAddrMask);
+	ADBCommand eCode = ADBCommand((command >> ADBAnalyzer::mADBCommandCodeShift) & ADBAnalyzer::mADBCommandCodeMask);
+	U8 uiReg = ((command >> ADBAnalyzer::mADBCommandRegShift) & ADBAnalyzer::mADBCommandRegMask);
+
+	/* Output command byte fields */
+	AnalyzerHelpers::GetNumberString(uiAddr, display_base, 8, number_str, 128);
+	ss << number_str;
+	ss << " " << ADBAnalyzer::CmdCodeRegToString(eCode, uiReg);
+	AnalyzerHelpers::GetNumberString(uiReg, display_base, 8, number_str, 128);
+	ss << " " << number_str;
+
+	/* Output data bytes */
+	for (U8 i = 0; i < data_len; i++)
+	{
+		AnalyzerHelpers::GetNumberString(data[i], display_base, 8, number_str, 128);
+		ss << " " << number_str;
+	}
+
+	if (service_request)
+	{
+		ss << " svcreq";
+	}
+
+	return ss.str();
+}
+
+std::string ADBAnalyzerResults::FormatPayload(U64 packet_id, DisplayBase display_base)
+{
+	std::string str;
+	if (!mStringCache.Lookup(PayloadString, packet_id, display_base, str))
+	{
+		U8 command;
+		U8 data[8];
+		U8 data_len;
+		bool service_request;
+		ReadPacket(packet_id, &command, data, &data_len, &service_request);
+
+		char payload_str[ 128 ];
+		ADBPayloadDecoder::Decode(command, data, data_len, payload_str, sizeof(payload_str));
+		str = payload_str;
+
+		mStringCache.Insert(PayloadString, packet_id, display_base, str);
+	}
+
+	return str;
+}
+
+void ADBAnalyzerResults::ReadPacket(U64 packet_id, U8 *pbyCommand, U8 *pabyData, U8 *puiDataLen, bool *pbServiceRequest)
+{
+	U64 first_frame;
+	U64 last_frame;
+	GetFramesContainedInPacket(packet_id, &first_frame, &last_frame);
+
+	ReadPacketFrames(first_frame, last_frame, pbyCommand, pabyData, puiDataLen, pbServiceRequest);
+}
+
+void ADBAnalyzerResults::ReadPacketFrames(U64 first_frame, U64 last_frame, U8 *pbyCommand, U8 *pabyData, U8 *puiDataLen, bool *pbServiceRequest)
+{
+	*pbyCommand = 0;
+	*puiDataLen = 0;
+	*pbServiceRequest = false;
+
+	for (U64 i = first_frame; i <= last_frame; i++)
+	{
+		Frame frame = GetFrame(i);
+
+		if (frame.mFlags & DATA_BYTE_FLAG)
+		{
+			/* Data byte */
+			if (*puiDataLen < 8) pabyData[(*puiDataLen)++] = U8(frame.mData1);
+		}
+		else
+		{
+			/* Command byte */
+			*pbyCommand = U8(frame.mData1);
+		}
+
+		/* Or in service request status */
+		*pbServiceRequest |= (0 != (frame.mFlags & SERVICE_REQUEST_FLAG));
+	}
 }
@@ -1,9 +1,22 @@
 #ifndef ADB_ANALYZER_RESULTS
 #define ADB_ANALYZER_RESULTS
 
+#pragma warning(push, 0)
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#pragma warning(pop)
+
 #include <AnalyzerResults.h>
+#include "ADBResultStringCache.h"
+#include "ADBStatistics.h"
+#include "ADBBusAnalytics.h"
+#include "ADBRegisterTimeline.h"
+#include "ADBTaskPool.h"
 
 class ADBAnalyzer;
+class ADBExportCompressor;
 class ADBAnalyzerSettings;
 
 class ADBAnalyzerResults : public AnalyzerResults
@@ -19,10 +32,127 @@ class ADBAnalyzerResults : public AnalyzerResults
 		virtual void GeneratePacketTabularText(U64 packet_id, DisplayBase display_base);
 		virtual void GenerateTransactionTabularText(U64 transaction_id, DisplayBase display_base);
 
+		/* Record samples a committed packet spans (attention pulse, command start, end of stop bit) and the frames it covers */
+		void AddPacketToIndex(U64 attention_sample, U64 start_sample, U64 end_sample, U64 first_frame, U64 last_frame);
+
+		/* Locate frames of packets starting within sample range (inclusive), end frame is exclusive */
+		bool GetFramesInSampleRange(U64 start_sample, U64 end_sample, U64 *first_frame, U64 *end_frame);
+
+		/* Bus statistics, updated by the analyzer */
+		ADBStatistics& GetStatistics() { return mStatistics; }
+
+		/* Bus timing analytics, updated by the analyzer */
+		ADBBusAnalytics& GetAnalytics() { return mAnalytics; }
+
+		/* Device register values over time, updated by the analyzer */
+		ADBRegisterTimeline& GetRegisterTimeline() { return mRegisterTimeline; }
+
+		/* Export is formatted in chunks of about this many frames, up to one per thread */
+		static const U64 mExportChunkFrames = 16 * 1024;
+
+		/* Path plain CSV is exported to instead, should compressing an export to file fail */
+		static std::string UncompressedExportPath(const char* file);
+
 	protected: // functions
+		/* Export frames in range as CSV, end frame is exclusive, through compressor if given */
+		void ExportFrames(void* f, DisplayBase display_base, U64 first_frame, U64 end_frame, ADBExportCompressor* compressor);
+
+		/* Write export output to file, or hand it to compressor if given (output may be left emptied) */
+		static void WriteExportOutput(void* f, std::string& output, ADBExportCompressor* compressor);
+
+		/* Locate first frame of a packet at or after frame (frame must be above zero), or end frame */
+		U64 FindPacketStart(U64 frame_index, U64 end_frame);
+
+		/* Format frames as CSV lines, frames must start and end at packet boundaries (safe on any thread) */
+		void FormatFrames(std::string& buffer, DisplayBase display_base, U64 trigger_sample, U32 sample_rate, const std::vector<Frame>& frames);
+
+		/* Export statistics summary and per command counts as CSV */
+		void ExportStatisticsFile(void* f, DisplayBase display_base);
+
+		/* Export analytics summary and histograms as CSV */
+		void ExportAnalyticsFile(void* f, DisplayBase display_base);
+
+		/* Export register values at export window start and changes within it as CSV */
+		void ExportRegisterTimelineFile(void* f, DisplayBase display_base);
+
+		/* Export every committed packet as a binary transaction record */
+		void ExportTraceFile(void* f);
+
+		/* Output register change line */
+		static void OutputRegisterChange(std::stringstream& ss, DisplayBase display_base, U64 trigger_sample, U32 sample_rate, U8 addr, U8 reg, const ADBRegisterChange& change);
+
+		/* Output summary / histogram lines for an analytics histogram */
+		static void OutputHistogramSummary(std::stringstream& ss, const char* metric, const char* address, const ADBHistogram& histogram);
+		static void OutputHistogramBuckets(std::stringstream& ss, const char* metric, const char* address, const ADBHistogram& histogram);
+
+		/* Output empty data columns, service request, optional payload description and end line */
+		void OutputLineEnd(std::string& buffer, U8 command, const U8 *data, U8 data_count, bool service_request);
+
+		/* Output CSV field, quoted if it needs to be */
+		static void OutputCsvField(std::string& buffer, const char* field);
+
+		/* Convert time relative to trigger in seconds to sample number */
+		static U64 TimeToSample(const char* time_str, U64 trigger_sample, U32 sample_rate, U64 default_sample);
+
+		/* Short and long descriptions of a statistics only mode event frame, returns false for a byte frame */
+		static bool DescribeEventFrame(const Frame& frame, const char** short_str, const char** long_str);
+
+		/* Format data byte of frame */
+		std::string FormatFrameByte(const Frame& frame, DisplayBase display_base);
+
+		/* Format bubble strings of frame, shortest first, separated by line breaks, complete is false if its packet isn't committed yet */
+		std::string FormatBubble(U64 frame_index, DisplayBase display_base, bool* complete);
+
+		/* Format command, data and service request of packet on a single line */
+		std::string FormatPacket(U64 packet_id, DisplayBase display_base);
+
+		/* Describe device payload of packet (cached, empty if not understood) */
+		std::string FormatPayload(U64 packet_id, DisplayBase display_base);
+
+		/* Collect command, data and service request status of packet */
+		void ReadPacket(U64 packet_id, U8 *pbyCommand, U8 *pabyData, U8 *puiDataLen, bool *pbServiceRequest);
+
+		/* As above, from the frames packet covers (inclusive) */
+		void ReadPacketFrames(U64 first_frame, U64 last_frame, U8 *pbyCommand, U8 *pabyData, U8 *puiDataLen, bool *pbServiceRequest);
+
 	protected: // vars
 		ADBAnalyzerSettings* mSettings;
 		ADBAnalyzer* mAnalyzer;
+
+		static const U32 mMaxExportThreads = 8;
+
+		/* Threads formatting export chunks, started by the first export */
+		ADBTaskPool mExportPool;
+
+		/* Trace records written at a time */
+		static const U32 mTraceRecordsPerWrite = 4096;
+
+		/* Number of formatted strings retained for the UI */
+		static const size_t mStringCacheSize = 4096;
+
+		/* Formatted bubble / tabular strings */
+		ADBResultStringCache mStringCache;
+
+		/* Span of each committed packet, in decode order (an entry for every packet, which trace export reads in turn) */
+		struct PacketIndexEntry
+		{
+			U64 uiAttentionSample;
+			U64 uiStartSample;
+			U64 uiEndSample;
+			U64 uiFirstFrame;
+			U64 uiLastFrame;
+		};
+		std::vector<PacketIndexEntry> mPacketIndex;
+		std::mutex mPacketIndexMutex;
+
+		/* Bus statistics */
+		ADBStatistics mStatistics;
+
+		/* Bus timing analytics */
+		ADBBusAnalytics mAnalytics;
+
+		/* Device register values */
+		ADBRegisterTimeline mRegisterTimeline;
 };
 
 #endif // ADB_ANALYZER_RESULTS
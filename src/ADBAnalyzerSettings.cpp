@@ -1,24 +1,176 @@
 #include "ADBAnalyzerSettings.h"
 
 #include <AnalyzerHelpers.h>
+#include "ADBTransactionMatcher.h"
+#include "ADBSimulationDataGenerator.h"
 #include <sstream>
 #include <cstring>
+#include <cstdlib>
 
 #pragma warning(disable : 4800) // warning C4800: 'U32' : forcing value to bool 'true' or 'false' (performance warning)
 #pragma warning(disable : 4996) // warning C4996: 'sprintf': This function or variable may be unsafe. Consider using sprintf_s instead.
 
 ADBAnalyzerSettings::ADBAnalyzerSettings()
-	: mInputChannel(UNDEFINED_CHANNEL)
+	: mInputChannel(UNDEFINED_CHANNEL), mDecodePayloads(false), mGlitchFilterNs(0),
+	  mHostErrorPct(3), mDeviceErrorPct(30), mLowTimeErrorPct(5), mStopToStartMinUs(140), mStopToStartMaxUs(260),
+	  mStatisticsOnly(false), mUtilizationWindowMs(100), mMatchesOnly(false),
+	  mMarkerVerbosity(MarkersAll), mMarkFailedOrServiceRequestOnly(false),
+	  mAdaptiveDeviceTiming(false)
 {
 	mInputChannelInterface.reset(new AnalyzerSettingInterfaceChannel());
 	mInputChannelInterface->SetTitleAndTooltip("ADB", "Apple Desktop Bus");
 	mInputChannelInterface->SetChannel(mInputChannel);
 
+	mDecodePayloadsInterface.reset(new AnalyzerSettingInterfaceBool());
+	mDecodePayloadsInterface->SetTitleAndTooltip("Payloads", "Describe keyboard, mouse and register 3 payloads");
+	mDecodePayloadsInterface->SetCheckBoxText("Decode device payloads");
+	mDecodePayloadsInterface->SetValue(mDecodePayloads);
+
+	mGlitchFilterInterface.reset(new AnalyzerSettingInterfaceNumberList());
+	mGlitchFilterInterface->SetTitleAndTooltip("Glitch filter", "Ignore pulses narrower than this before decoding");
+	mGlitchFilterInterface->AddNumber(0, "Off", "All pulses are decoded");
+	mGlitchFilterInterface->AddNumber(500, "0.5 us", "Ignore pulses narrower than 0.5 us");
+	mGlitchFilterInterface->AddNumber(1000, "1 us", "Ignore pulses narrower than 1 us");
+	mGlitchFilterInterface->AddNumber(2000, "2 us", "Ignore pulses narrower than 2 us");
+	mGlitchFilterInterface->AddNumber(5000, "5 us", "Ignore pulses narrower than 5 us");
+	mGlitchFilterInterface->SetNumber(mGlitchFilterNs);
+
+	mHostErrorPctInterface.reset(new AnalyzerSettingInterfaceInteger());
+	mHostErrorPctInterface->SetTitleAndTooltip("Host timing error (%)", "Allowed host timing error, +/- percent of nominal");
+	mHostErrorPctInterface->SetMin(0);
+	mHostErrorPctInterface->SetMax(50);
+	mHostErrorPctInterface->SetInteger(mHostErrorPct);
+
+	mDeviceErrorPctInterface.reset(new AnalyzerSettingInterfaceInteger());
+	mDeviceErrorPctInterface->SetTitleAndTooltip("Device timing error (%)", "Allowed device timing error, +/- percent of nominal");
+	mDeviceErrorPctInterface->SetMin(0);
+	mDeviceErrorPctInterface->SetMax(60);
+	mDeviceErrorPctInterface->SetInteger(mDeviceErrorPct);
+
+	mLowTimeErrorPctInterface.reset(new AnalyzerSettingInterfaceInteger());
+	mLowTimeErrorPctInterface->SetTitleAndTooltip("Bit low time error (%)", "Allowed error of bit cell low time, +/- percent of bit cell");
+	mLowTimeErrorPctInterface->SetMin(0);
+	mLowTimeErrorPctInterface->SetMax(30);
+	mLowTimeErrorPctInterface->SetInteger(mLowTimeErrorPct);
+
+	mStopToStartMinUsInterface.reset(new AnalyzerSettingInterfaceInteger());
+	mStopToStartMinUsInterface->SetTitleAndTooltip("Stop to start min (us)", "Minimum time from command stop bit to data start bit");
+	mStopToStartMinUsInterface->SetMin(0);
+	mStopToStartMinUsInterface->SetMax(10000);
+	mStopToStartMinUsInterface->SetInteger(mStopToStartMinUs);
+
+	mStopToStartMaxUsInterface.reset(new AnalyzerSettingInterfaceInteger());
+	mStopToStartMaxUsInterface->SetTitleAndTooltip("Stop to start max (us)", "Maximum time from command stop bit to data start bit");
+	mStopToStartMaxUsInterface->SetMin(0);
+	mStopToStartMaxUsInterface->SetMax(10000);
+	mStopToStartMaxUsInterface->SetInteger(mStopToStartMaxUs);
+
+	mExportWindowStartInterface.reset(new AnalyzerSettingInterfaceText());
+	mExportWindowStartInterface->SetTitleAndTooltip("Export window start (s)", "Start of time window export, relative to trigger, empty for start of capture");
+	mExportWindowStartInterface->SetText(mExportWindowStart.c_str());
+
+	mExportWindowEndInterface.reset(new AnalyzerSettingInterfaceText());
+	mExportWindowEndInterface->SetTitleAndTooltip("Export window end (s)", "End of time window export, relative to trigger, empty for end of capture");
+	mExportWindowEndInterface->SetText(mExportWindowEnd.c_str());
+
+	mStatisticsOnlyInterface.reset(new AnalyzerSettingInterfaceBool());
+	mStatisticsOnlyInterface->SetTitleAndTooltip("Soak mode", "Keep bus statistics only, marking just errors, resets and service request storms");
+	mStatisticsOnlyInterface->SetCheckBoxText("Statistics only");
+	mStatisticsOnlyInterface->SetValue(mStatisticsOnly);
+
+	mUtilizationWindowInterface.reset(new AnalyzerSettingInterfaceNumberList());
+	mUtilizationWindowInterface->SetTitleAndTooltip("Utilization window", "Length of windows bus utilization is measured over");
+	mUtilizationWindowInterface->AddNumber(10, "10 ms", "Measure utilization over 10 ms windows");
+	mUtilizationWindowInterface->AddNumber(100, "100 ms", "Measure utilization over 100 ms windows");
+	mUtilizationWindowInterface->AddNumber(1000, "1 s", "Measure utilization over 1 s windows");
+	mUtilizationWindowInterface->SetNumber(mUtilizationWindowMs);
+
+	mMatchPatternsInterface.reset(new AnalyzerSettingInterfaceText());
+	mMatchPatternsInterface->SetTitleAndTooltip("Match patterns", "Transactions to mark, ';' separated: addr cmd reg [data[/mask] ...] [srq|!srq], '*' for any, e.g. '2 talk 0 39/7f'");
+	mMatchPatternsInterface->SetText(mMatchPatterns.c_str());
+
+	mMatchesOnlyInterface.reset(new AnalyzerSettingInterfaceBool());
+	mMatchesOnlyInterface->SetTitleAndTooltip("Matches only", "Output only transactions matching a pattern");
+	mMatchesOnlyInterface->SetCheckBoxText("Hide transactions not matching a pattern");
+	mMatchesOnlyInterface->SetValue(mMatchesOnly);
+
+	mMarkerVerbosityInterface.reset(new AnalyzerSettingInterfaceNumberList());
+	mMarkerVerbosityInterface->SetTitleAndTooltip("Markers", "Markers placed on the waveform");
+	mMarkerVerbosityInterface->AddNumber(MarkersAll, "All", "Sync, start, stop, service request and global reset markers");
+	mMarkerVerbosityInterface->AddNumber(MarkersServiceRequestsAndResets, "Service requests and resets", "Service request and global reset markers only");
+	mMarkerVerbosityInterface->AddNumber(MarkersNone, "None", "No markers");
+	mMarkerVerbosityInterface->SetNumber(mMarkerVerbosity);
+
+	mMarkFailedOrServiceRequestOnlyInterface.reset(new AnalyzerSettingInterfaceBool());
+	mMarkFailedOrServiceRequestOnlyInterface->SetTitleAndTooltip("Sparse markers", "Only place markers on transactions which fail or carry a service request");
+	mMarkFailedOrServiceRequestOnlyInterface->SetCheckBoxText("Mark failed / service request transactions only");
+	mMarkFailedOrServiceRequestOnlyInterface->SetValue(mMarkFailedOrServiceRequestOnly);
+
+	mAdaptiveDeviceTimingInterface.reset(new AnalyzerSettingInterfaceBool());
+	mAdaptiveDeviceTimingInterface->SetTitleAndTooltip("Adaptive device timing", "Centre device timing windows on the bit cell measured from each response's start bit, tracked per address");
+	mAdaptiveDeviceTimingInterface->SetCheckBoxText("Track device bit cell");
+	mAdaptiveDeviceTimingInterface->SetValue(mAdaptiveDeviceTiming);
+
+	mStreamPathInterface.reset(new AnalyzerSettingInterfaceText());
+	mStreamPathInterface->SetTitleAndTooltip("Live stream", "Unix domain socket path (named pipe such as \\\\.\\pipe\\adb on Windows) to publish each transaction to as it's decoded, empty for none");
+	mStreamPathInterface->SetText(mStreamPath.c_str());
+
+	mSimulationFaultsInterface.reset(new AnalyzerSettingInterfaceText());
+	mSimulationFaultsInterface->SetTitleAndTooltip("Simulation faults", "Percentage of simulated transactions to inject each fault into: glitch, truncate, cell, stop, reset, srq, e.g. 'glitch=2 truncate=1 reset=0.5'");
+	mSimulationFaultsInterface->SetText(mSimulationFaults.c_str());
+
+	mDecodeLagLogPathInterface.reset(new AnalyzerSettingInterfaceText());
+	mDecodeLagLogPathInterface->SetTitleAndTooltip("Decode lag log", "File to log how far decoding lags behind a streaming capture to, once a second, empty for none");
+	mDecodeLagLogPathInterface->SetText(mDecodeLagLogPath.c_str());
+
 	AddInterface(mInputChannelInterface.get());
+	AddInterface(mDecodePayloadsInterface.get());
+	AddInterface(mGlitchFilterInterface.get());
+	AddInterface(mHostErrorPctInterface.get());
+	AddInterface(mDeviceErrorPctInterface.get());
+	AddInterface(mLowTimeErrorPctInterface.get());
+	AddInterface(mStopToStartMinUsInterface.get());
+	AddInterface(mStopToStartMaxUsInterface.get());
+	AddInterface(mExportWindowStartInterface.get());
+	AddInterface(mExportWindowEndInterface.get());
+	AddInterface(mStatisticsOnlyInterface.get());
+	AddInterface(mUtilizationWindowInterface.get());
+	AddInterface(mMatchPatternsInterface.get());
+	AddInterface(mMatchesOnlyInterface.get());
+	AddInterface(mMarkerVerbosityInterface.get());
+	AddInterface(mMarkFailedOrServiceRequestOnlyInterface.get());
+	AddInterface(mAdaptiveDeviceTimingInterface.get());
+	AddInterface(mStreamPathInterface.get());
+	AddInterface(mSimulationFaultsInterface.get());
+	AddInterface(mDecodeLagLogPathInterface.get());
+
+	AddExportOption(ExportCsv, "Export as text/csv file");
+	AddExportExtension(ExportCsv, "text", "txt");
+	AddExportExtension(ExportCsv, "csv", "csv");
+
+	AddExportOption(ExportCsvTimeWindow, "Export time window as text/csv file");
+	AddExportExtension(ExportCsvTimeWindow, "text", "txt");
+	AddExportExtension(ExportCsvTimeWindow, "csv", "csv");
 
-	AddExportOption(0, "Export as text/csv file");
-	AddExportExtension(0, "text", "txt");
-	AddExportExtension(0, "csv", "csv");
+	AddExportOption(ExportStatistics, "Export statistics as text/csv file");
+	AddExportExtension(ExportStatistics, "text", "txt");
+	AddExportExtension(ExportStatistics, "csv", "csv");
+
+	AddExportOption(ExportAnalytics, "Export bus analytics as text/csv file");
+	AddExportExtension(ExportAnalytics, "text", "txt");
+	AddExportExtension(ExportAnalytics, "csv", "csv");
+
+	AddExportOption(ExportRegisterTimeline, "Export register timeline as text/csv file");
+	AddExportExtension(ExportRegisterTimeline, "text", "txt");
+	AddExportExtension(ExportRegisterTimeline, "csv", "csv");
+
+	AddExportOption(ExportTrace, "Export transactions as binary trace file");
+	AddExportExtension(ExportTrace, "trace", "adbtrace");
+
+#ifdef ADB_HAVE_ZLIB
+	AddExportOption(ExportCsvCompressed, "Export as compressed text/csv file");
+	AddExportExtension(ExportCsvCompressed, "gzip", "gz");
+#endif
 
 	ClearChannels();
 	AddChannel(mInputChannel, "ADB", false);
@@ -30,7 +182,54 @@ ADBAnalyzerSettings::~ADBAnalyzerSettings()
 
 bool ADBAnalyzerSettings::SetSettingsFromInterfaces()
 {
+	if (!IsValidTime(mExportWindowStartInterface->GetText()) || !IsValidTime(mExportWindowEndInterface->GetText()))
+	{
+		SetErrorText("Export window times must be empty or a number of seconds");
+		return false;
+	}
+
+	if (mStopToStartMinUsInterface->GetInteger() > mStopToStartMaxUsInterface->GetInteger())
+	{
+		SetErrorText("Stop to start min must not exceed max");
+		return false;
+	}
+
+	ADBTransactionMatcher matcher;
+	std::string match_error;
+	if (!matcher.Compile(mMatchPatternsInterface->GetText(), &match_error))
+	{
+		SetErrorText(match_error.c_str());
+		return false;
+	}
+
+	U32 auiFaultRates[SimNumFaults];
+	std::string fault_error;
+	if (!ADBSimulationDataGenerator::ParseFaults(mSimulationFaultsInterface->GetText(), auiFaultRates, &fault_error))
+	{
+		SetErrorText(fault_error.c_str());
+		return false;
+	}
+
 	mInputChannel = mInputChannelInterface->GetChannel();
+	mDecodePayloads = mDecodePayloadsInterface->GetValue();
+	mGlitchFilterNs = U32(mGlitchFilterInterface->GetNumber());
+	mHostErrorPct = mHostErrorPctInterface->GetInteger();
+	mDeviceErrorPct = mDeviceErrorPctInterface->GetInteger();
+	mLowTimeErrorPct = mLowTimeErrorPctInterface->GetInteger();
+	mStopToStartMinUs = mStopToStartMinUsInterface->GetInteger();
+	mStopToStartMaxUs = mStopToStartMaxUsInterface->GetInteger();
+	mExportWindowStart = mExportWindowStartInterface->GetText();
+	mExportWindowEnd = mExportWindowEndInterface->GetText();
+	mStatisticsOnly = mStatisticsOnlyInterface->GetValue();
+	mUtilizationWindowMs = U32(mUtilizationWindowInterface->GetNumber());
+	mMatchPatterns = mMatchPatternsInterface->GetText();
+	mMatchesOnly = mMatchesOnlyInterface->GetValue();
+	mMarkerVerbosity = U32(mMarkerVerbosityInterface->GetNumber());
+	mMarkFailedOrServiceRequestOnly = mMarkFailedOrServiceRequestOnlyInterface->GetValue();
+	mAdaptiveDeviceTiming = mAdaptiveDeviceTimingInterface->GetValue();
+	mStreamPath = mStreamPathInterface->GetText();
+	mSimulationFaults = mSimulationFaultsInterface->GetText();
+	mDecodeLagLogPath = mDecodeLagLogPathInterface->GetText();
 	ClearChannels();
 	AddChannel(mInputChannel, "ADB", true);
 
@@ -48,6 +247,38 @@ void ADBAnalyzerSettings::LoadSettings(const char* settings)
 
 	text_archive >> mInputChannel;
 
+	/* Settings added after the initial release, keep defaults if absent */
+	if (!(text_archive >> mDecodePayloads)) mDecodePayloads = false;
+	if (!(text_archive >> mGlitchFilterNs)) mGlitchFilterNs = 0;
+
+	const char* window_string;
+	mExportWindowStart = (text_archive >> &window_string) ? window_string : "";
+	mExportWindowEnd = (text_archive >> &window_string) ? window_string : "";
+
+	if (!(text_archive >> mHostErrorPct)) mHostErrorPct = 3;
+	if (!(text_archive >> mDeviceErrorPct)) mDeviceErrorPct = 30;
+	if (!(text_archive >> mLowTimeErrorPct)) mLowTimeErrorPct = 5;
+	if (!(text_archive >> mStopToStartMinUs)) mStopToStartMinUs = 140;
+	if (!(text_archive >> mStopToStartMaxUs)) mStopToStartMaxUs = 260;
+	if (!(text_archive >> mStatisticsOnly)) mStatisticsOnly = false;
+	if (!(text_archive >> mUtilizationWindowMs)) mUtilizationWindowMs = 100;
+
+	const char* patterns_string;
+	mMatchPatterns = (text_archive >> &patterns_string) ? patterns_string : "";
+	if (!(text_archive >> mMatchesOnly)) mMatchesOnly = false;
+	if (!(text_archive >> mMarkerVerbosity)) mMarkerVerbosity = MarkersAll;
+	if (!(text_archive >> mMarkFailedOrServiceRequestOnly)) mMarkFailedOrServiceRequestOnly = false;
+	if (!(text_archive >> mAdaptiveDeviceTiming)) mAdaptiveDeviceTiming = false;
+
+	const char* stream_string;
+	mStreamPath = (text_archive >> &stream_string) ? stream_string : "";
+
+	const char* faults_string;
+	mSimulationFaults = (text_archive >> &faults_string) ? faults_string : "";
+
+	const char* lag_string;
+	mDecodeLagLogPath = (text_archive >> &lag_string) ? lag_string : "";
+
 	ClearChannels();
 	AddChannel(mInputChannel, "ADB", true);
 
@@ -60,6 +291,25 @@ const char* ADBAnalyzerSettings::SaveSettings()
 
 	text_archive << "ADBAnalyzer";
 	text_archive << mInputChannel;
+	text_archive << mDecodePayloads;
+	text_archive << mGlitchFilterNs;
+	text_archive << mExportWindowStart.c_str();
+	text_archive << mExportWindowEnd.c_str();
+	text_archive << mHostErrorPct;
+	text_archive << mDeviceErrorPct;
+	text_archive << mLowTimeErrorPct;
+	text_archive << mStopToStartMinUs;
+	text_archive << mStopToStartMaxUs;
+	text_archive << mStatisticsOnly;
+	text_archive << mUtilizationWindowMs;
+	text_archive << mMatchPatterns.c_str();
+	text_archive << mMatchesOnly;
+	text_archive << mMarkerVerbosity;
+	text_archive << mMarkFailedOrServiceRequestOnly;
+	text_archive << mAdaptiveDeviceTiming;
+	text_archive << mStreamPath.c_str();
+	text_archive << mSimulationFaults.c_str();
+	text_archive << mDecodeLagLogPath.c_str();
 
 	return SetReturnString(text_archive.GetString());
 }
@@ -67,4 +317,33 @@ const char* ADBAnalyzerSettings::SaveSettings()
 void ADBAnalyzerSettings::UpdateInterfacesFromSettings()
 {
 	mInputChannelInterface->SetChannel(mInputChannel);
+	mDecodePayloadsInterface->SetValue(mDecodePayloads);
+	mGlitchFilterInterface->SetNumber(mGlitchFilterNs);
+	mHostErrorPctInterface->SetInteger(mHostErrorPct);
+	mDeviceErrorPctInterface->SetInteger(mDeviceErrorPct);
+	mLowTimeErrorPctInterface->SetInteger(mLowTimeErrorPct);
+	mStopToStartMinUsInterface->SetInteger(mStopToStartMinUs);
+	mStopToStartMaxUsInterface->SetInteger(mStopToStartMaxUs);
+	mExportWindowStartInterface->SetText(mExportWindowStart.c_str());
+	mExportWindowEndInterface->SetText(mExportWindowEnd.c_str());
+	mStatisticsOnlyInterface->SetValue(mStatisticsOnly);
+	mUtilizationWindowInterface->SetNumber(mUtilizationWindowMs);
+	mMatchPatternsInterface->SetText(mMatchPatterns.c_str());
+	mMatchesOnlyInterface->SetValue(mMatchesOnly);
+	mMarkerVerbosityInterface->SetNumber(mMarkerVerbosity);
+	mMarkFailedOrServiceRequestOnlyInterface->SetValue(mMarkFailedOrServiceRequestOnly);
+	mAdaptiveDeviceTimingInterface->SetValue(mAdaptiveDeviceTiming);
+	mStreamPathInterface->SetText(mStreamPath.c_str());
+	mSimulationFaultsInterface->SetText(mSimulationFaults.c_str());
+	mDecodeLagLogPathInterface->SetText(mDecodeLagLogPath.c_str());
+}
+
+bool ADBAnalyzerSettings::IsValidTime(const char* time_str)
+{
+	if ('\0' == time_str[0]) return true;
+
+	char* end;
+	strtod(time_str, &end);
+
+	return ('\0' == *end);
 }
@@ -1,9 +1,51 @@
 #ifndef ADB_ANALYZER_SETTINGS
 #define ADB_ANALYZER_SETTINGS
 
+#pragma warning(push, 0)
+#include <string>
+#pragma warning(pop)
+
 #include <AnalyzerSettings.h>
 #include <AnalyzerTypes.h>
 
+/* Export type user IDs */
+enum ADBExportType
+{
+	/* Whole capture as CSV */
+	ExportCsv = 0,
+
+	/* Packets starting within the export time window as CSV */
+	ExportCsvTimeWindow = 1,
+
+	/* Bus statistics as CSV */
+	ExportStatistics = 2,
+
+	/* Bus utilization, polling interval and service request latency as CSV */
+	ExportAnalytics = 3,
+
+	/* Register value changes */
+	ExportRegisterTimeline = 4,
+
+	/* Whole capture as gzip compressed CSV (only when built with zlib) */
+	ExportCsvCompressed = 5,
+
+	/* Whole capture as binary transaction records, as the live stream */
+	ExportTrace = 6
+};
+
+/* Marker verbosity levels */
+enum ADBMarkerVerbosity
+{
+	/* Sync, start, stop, service request and global reset markers */
+	MarkersAll = 0,
+
+	/* Service request and global reset markers only */
+	MarkersServiceRequestsAndResets = 1,
+
+	/* No markers */
+	MarkersNone = 2
+};
+
 class ADBAnalyzerSettings : public AnalyzerSettings
 {
 	public:
@@ -18,8 +60,77 @@ class ADBAnalyzerSettings : public AnalyzerSettings
 
 		Channel mInputChannel;
 
+		/* Describe keyboard, mouse and register 3 payloads in table and export */
+		bool mDecodePayloads;
+
+		/* Pulses narrower than this are ignored by the decoder (zero to disable) */
+		U32 mGlitchFilterNs;
+
+		/* Timing tolerances, host / device errors as a percentage of nominal bit cell timing */
+		U32 mHostErrorPct;
+		U32 mDeviceErrorPct;
+
+		/* Tolerance of bit cell low time, as a percentage of bit cell */
+		U32 mLowTimeErrorPct;
+
+		/* Allowed time from command stop bit to data start bit */
+		U32 mStopToStartMinUs;
+		U32 mStopToStartMaxUs;
+
+		/* Time window export start and end, seconds relative to trigger (empty for open ended) */
+		std::string mExportWindowStart;
+		std::string mExportWindowEnd;
+
+		/* Keep statistics only, outputting frames for errors, resets and service request storms */
+		bool mStatisticsOnly;
+
+		/* Length of windows bus utilization is measured over */
+		U32 mUtilizationWindowMs;
+
+		/* Transaction patterns to mark (see ADBTransactionMatcher), and whether to output only matches */
+		std::string mMatchPatterns;
+		bool mMatchesOnly;
+
+		/* Markers output, and whether only for transactions which fail or carry a service request */
+		U32 mMarkerVerbosity;
+		bool mMarkFailedOrServiceRequestOnly;
+
+		/* Centre device timing windows on the bit cell measured from each response */
+		bool mAdaptiveDeviceTiming;
+
+		/* Socket / pipe to publish completed transactions to (empty for none) */
+		std::string mStreamPath;
+
+		/* Faults injected into simulated transactions (see ADBSimulationDataGenerator::ParseFaults) */
+		std::string mSimulationFaults;
+
+		/* File to log decode lag to (empty for none) */
+		std::string mDecodeLagLogPath;
+
 	protected:
 		std::unique_ptr<AnalyzerSettingInterfaceChannel> mInputChannelInterface;
+		std::unique_ptr<AnalyzerSettingInterfaceBool> mDecodePayloadsInterface;
+		std::unique_ptr<AnalyzerSettingInterfaceNumberList> mGlitchFilterInterface;
+		std::unique_ptr<AnalyzerSettingInterfaceInteger> mHostErrorPctInterface;
+		std::unique_ptr<AnalyzerSettingInterfaceInteger> mDeviceErrorPctInterface;
+		std::unique_ptr<AnalyzerSettingInterfaceInteger> mLowTimeErrorPctInterface;
+		std::unique_ptr<AnalyzerSettingInterfaceInteger> mStopToStartMinUsInterface;
+		std::unique_ptr<AnalyzerSettingInterfaceInteger> mStopToStartMaxUsInterface;
+		std::unique_ptr<AnalyzerSettingInterfaceText> mExportWindowStartInterface;
+		std::unique_ptr<AnalyzerSettingInterfaceText> mExportWindowEndInterface;
+		std::unique_ptr<AnalyzerSettingInterfaceBool> mStatisticsOnlyInterface;
+		std::unique_ptr<AnalyzerSettingInterfaceNumberList> mUtilizationWindowInterface;
+		std::unique_ptr<AnalyzerSettingInterfaceText> mMatchPatternsInterface;
+		std::unique_ptr<AnalyzerSettingInterfaceBool> mMatchesOnlyInterface;
+		std::unique_ptr<AnalyzerSettingInterfaceNumberList> mMarkerVerbosityInterface;
+		std::unique_ptr<AnalyzerSettingInterfaceBool> mMarkFailedOrServiceRequestOnlyInterface;
+		std::unique_ptr<AnalyzerSettingInterfaceBool> mAdaptiveDeviceTimingInterface;
+		std::unique_ptr<AnalyzerSettingInterfaceText> mStreamPathInterface;
+		std::unique_ptr<AnalyzerSettingInterfaceText> mSimulationFaultsInterface;
+		std::unique_ptr<AnalyzerSettingInterfaceText> mDecodeLagLogPathInterface;
+
+		/* Check time is empty or a number */
+		static bool IsValidTime(const char* time_str);
 };
 
 #endif // ADB_ANALYZER_SETTINGS_SETTINGS
@@ -0,0 +1,163 @@
+#include "ADBBusAnalytics.h"
+#include "ADBAnalyzer.h"
+
+ADBBusAnalytics::ADBBusAnalytics()
+{
+	Reset(1000000, 100);
+}
+
+ADBBusAnalytics::~ADBBusAnalytics()
+{
+}
+
+void ADBBusAnalytics::Reset(U32 uiSampleRate, U32 uiWindowMs)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	mData.cUtilization.Clear();
+	mData.cServiceRequestLatency.Clear();
+	for (U32 i = 0; i < ADB_NUM_ADDRESSES; i++)
+	{
+		mData.acPollInterval[i].Clear();
+		mData.acServiceRequestLatency[i].Clear();
+		mPollValid[i] = false;
+		mPollStart[i] = 0;
+	}
+
+	mSampleRate = uiSampleRate;
+	mWindowMs = uiWindowMs;
+	mWindowSamples = (U64(uiSampleRate) * uiWindowMs) / 1000;
+	if (0 == mWindowSamples) mWindowSamples = 1;
+
+	mWindowValid = false;
+	mWindow = 0;
+	mWindowBusy = 0;
+
+	mServiceRequests.Reset();
+}
+
+void ADBBusAnalytics::AddTransaction(U8 byCommand, U8 uiDataLen, bool bServiceRequested, U64 uiStart, U64 uiEnd)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	/* Decode command */
+	U8 uiAddr = ((byCommand >> ADBAnalyzer::mADBCommandAddrShift) & ADBAnalyzer::mADBCommandAddrMask);
+	ADBCommand eCode = ADBCommand((byCommand >> ADBAnalyzer::mADBCommandCodeShift) & ADBAnalyzer::mADBCommandCodeMask);
+
+	AddBusy(uiStart, uiEnd);
+
+	/* Polling interval */
+	if (Talk == eCode)
+	{
+		if (mPollValid[uiAddr])
+		{
+			mData.acPollInterval[uiAddr].Add(SamplesToUs(uiStart - mPollStart[uiAddr]));
+		}
+		mPollValid[uiAddr] = true;
+		mPollStart[uiAddr] = uiStart;
+	}
+
+	/* Service request latency, against the device serviced */
+	U8 uiServicedAddr;
+	U64 uiRequestStart;
+	U64 uiServiceStart;
+	if (mServiceRequests.AddTransaction(byCommand, uiDataLen, bServiceRequested, uiStart, uiEnd, &uiServicedAddr, &uiRequestStart, &uiServiceStart))
+	{
+		U64 uiLatency = SamplesToUs(uiServiceStart - uiRequestStart);
+		mData.cServiceRequestLatency.Add(uiLatency);
+		mData.acServiceRequestLatency[uiServicedAddr].Add(uiLatency);
+	}
+}
+
+void ADBBusAnalytics::AddBusy(U64 uiStart, U64 uiEnd)
+{
+	while (uiStart < uiEnd)
+	{
+		U64 uiWindow = uiStart / mWindowSamples;
+
+		if (!mWindowValid)
+		{
+			/* Windows are counted from the first transaction */
+			mWindowValid = true;
+			mWindow = uiWindow;
+			mWindowBusy = 0;
+		}
+		else if (uiWindow != mWindow)
+		{
+			/* Window complete, count it and any idle windows since */
+			mData.cUtilization.Add((mWindowBusy * 100) / mWindowSamples);
+			mData.cUtilization.Add(0, uiWindow - mWindow - 1);
+
+			mWindow = uiWindow;
+			mWindowBusy = 0;
+		}
+
+		/* Busy period up to end of window */
+		U64 uiWindowEnd = (uiWindow + 1) * mWindowSamples;
+		U64 uiBusyEnd = (uiEnd < uiWindowEnd) ? uiEnd : uiWindowEnd;
+		mWindowBusy += uiBusyEnd - uiStart;
+		uiStart = uiBusyEnd;
+	}
+}
+
+void ADBBusAnalytics::GetSnapshot(ADBBusAnalyticsData* pData)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	*pData = mData;
+}
+
+ADBServiceRequestTracker::ADBServiceRequestTracker()
+{
+	Reset();
+}
+
+void ADBServiceRequestTracker::Reset()
+{
+	mPending = false;
+	mRequestStart = 0;
+	mCandidate = false;
+	mCandidateAddr = 0;
+	mCandidateStart = 0;
+}
+
+bool ADBServiceRequestTracker::AddTransaction(U8 byCommand, U8 uiDataLen, bool bServiceRequested, U64 uiStart, U64 uiEnd, U8* puiAddr, U64* puiRequestStart, U64* puiServiceStart)
+{
+	/* Decode command */
+	U8 uiAddr = ((byCommand >> ADBAnalyzer::mADBCommandAddrShift) & ADBAnalyzer::mADBCommandAddrMask);
+	ADBCommand eCode = ADBCommand((byCommand >> ADBAnalyzer::mADBCommandCodeShift) & ADBAnalyzer::mADBCommandCodeMask);
+	U8 uiReg = ((byCommand >> ADBAnalyzer::mADBCommandRegShift) & ADBAnalyzer::mADBCommandRegMask);
+
+	bool bServiced = false;
+
+	/* A command to any other address shows whether the device answering talk register 0 still holds the request */
+	if (mCandidate && (uiAddr != mCandidateAddr))
+	{
+		if (!bServiceRequested)
+		{
+			*puiAddr = mCandidateAddr;
+			*puiRequestStart = mRequestStart;
+			*puiServiceStart = mCandidateStart;
+			mPending = false;
+			bServiced = true;
+		}
+		mCandidate = false;
+	}
+
+	/* Device answering talk register 0, while no other holds a request, may be servicing pending request */
+	if (mPending && (Talk == eCode) && (0 == uiReg) && (uiDataLen > 0) && !bServiceRequested)
+	{
+		mCandidate = true;
+		mCandidateAddr = uiAddr;
+		mCandidateStart = uiStart;
+	}
+
+	/* Start of service request (a device still requesting after being serviced starts a new one) */
+	if (bServiceRequested && !mPending)
+	{
+		mPending = true;
+		mRequestStart = uiEnd;
+	}
+
+	return bServiced;
+}
@@ -0,0 +1,123 @@
+#ifndef ADB_BUS_ANALYTICS
+#define ADB_BUS_ANALYTICS
+
+#pragma warning(push, 0)
+#include <mutex>
+#pragma warning(pop)
+
+#include <LogicPublicTypes.h>
+#include "ADBHistogram.h"
+
+/* Number of ADB addresses */
+#define ADB_NUM_ADDRESSES 16
+
+/* Snapshot of bus analytics */
+struct ADBBusAnalyticsData
+{
+	/* Percentage of each complete utilization window the bus was busy */
+	ADBHistogram cUtilization;
+
+	/* Time between successive talk commands to each address (us) */
+	ADBHistogram acPollInterval[ADB_NUM_ADDRESSES];
+
+	/* Time from service request until a device answers a talk (us), overall and per answering address */
+	ADBHistogram cServiceRequestLatency;
+	ADBHistogram acServiceRequestLatency[ADB_NUM_ADDRESSES];
+};
+
+/*
+** Follows service requests from the transaction raising one to the talk which
+** services it, as a device answering is the only way to tell which raised it.
+**
+** A service request is taken as pending from the end of the first transaction
+** carrying one, until the start of the talk register 0 which services it. The
+** host polls devices with talk register 0 until one answers with data, but
+** other talks (register 3 polling, for example) may be answered in between,
+** and a device with data needn't be the one requesting. A device only holds
+** a request during commands to other addresses, so an answered talk register
+** 0 services the request when its own command shows no request (nobody else
+** is requesting) and the next command to another address shows none either
+** (the answering device has stopped requesting).
+*/
+class ADBServiceRequestTracker
+{
+	public:
+		ADBServiceRequestTracker();
+
+		/* Forget any request */
+		void Reset();
+
+		/*
+		** Follow transaction, from attention pulse start to end of final stop bit.
+		** Returns true when it shows a request serviced, giving the address of the
+		** device serviced, where the request was first seen and where the talk
+		** servicing it started.
+		*/
+		bool AddTransaction(U8 byCommand, U8 uiDataLen, bool bServiceRequested, U64 uiStart, U64 uiEnd, U8* puiAddr, U64* puiRequestStart, U64* puiServiceStart);
+
+	protected:
+		/* Service request pending and where it was first seen */
+		bool mPending;
+		U64 mRequestStart;
+
+		/* Talk register 0 answered while pending, serviced the request unless it's still held */
+		bool mCandidate;
+		U8 mCandidateAddr;
+		U64 mCandidateStart;
+};
+
+/*
+** Timing analysis of completed transactions, held in constant memory. Updated
+** by the worker thread and read when exporting. Service requests are followed
+** as above.
+*/
+class ADBBusAnalytics
+{
+	public:
+		ADBBusAnalytics();
+		~ADBBusAnalytics();
+
+		/* Discard everything, set sample rate and utilization window length */
+		void Reset(U32 uiSampleRate, U32 uiWindowMs);
+
+		/* Count transaction, from attention pulse start to end of final stop bit */
+		void AddTransaction(U8 byCommand, U8 uiDataLen, bool bServiceRequested, U64 uiStart, U64 uiEnd);
+
+		/* Copy current values */
+		void GetSnapshot(ADBBusAnalyticsData* pData);
+
+		/* Utilization window length */
+		U32 GetWindowMs() { return mWindowMs; }
+
+	protected:
+		/* Add busy period to utilization windows */
+		void AddBusy(U64 uiStart, U64 uiEnd);
+
+		/* Convert sample count to microseconds */
+		U64 SamplesToUs(U64 uiSamples) { return U64((double(uiSamples) * 1000000.0) / double(mSampleRate)); }
+
+		/* Current values */
+		ADBBusAnalyticsData mData;
+
+		/* Configuration */
+		U32 mSampleRate;
+		U32 mWindowMs;
+		U64 mWindowSamples;
+
+		/* Utilization window in progress (index from start of capture) and samples busy within it */
+		bool mWindowValid;
+		U64 mWindow;
+		U64 mWindowBusy;
+
+		/* Start of last talk command to each address */
+		bool mPollValid[ADB_NUM_ADDRESSES];
+		U64 mPollStart[ADB_NUM_ADDRESSES];
+
+		/* Service requests until serviced */
+		ADBServiceRequestTracker mServiceRequests;
+
+		/* Export may read while the worker thread updates */
+		std::mutex mMutex;
+};
+
+#endif // ADB_BUS_ANALYTICS
@@ -0,0 +1,132 @@
+#include "ADBDecodeLag.h"
+
+#pragma warning(disable : 4996) // warning C4996: 'fopen': This function or variable may be unsafe. Consider using fopen_s instead.
+
+ADBDecodeLag::ADBDecodeLag()
+	: mFile(NULL), mSampleRate(1), mNextLine(0.0), mAnchorSample(0), mAnchorTime(0.0), mLagUnknown(false),
+	  mLag(0), mPeakLag(0), mSample(0)
+{
+}
+
+ADBDecodeLag::~ADBDecodeLag()
+{
+	Stop();
+}
+
+bool ADBDecodeLag::Start(const char* pszPath, U32 uiSampleRate, U64 uiStartSample)
+{
+	Stop();
+
+	mFile = fopen(pszPath, "w");
+	if (NULL == mFile) return false;
+
+	mSampleRate = uiSampleRate;
+	mStartTime = std::chrono::steady_clock::now();
+	mNextLine = 1.0;
+	mAnchorSample = uiStartSample;
+	mAnchorTime = 0.0;
+	mLagUnknown = false;
+	mLag = 0;
+	mPeakLag = 0;
+	mSample = uiStartSample;
+	mLagHistogram.Clear();
+
+	fprintf(mFile, "Elapsed [s],Decoded [s],Lag [ms],Peak [ms],P50 [ms],P90 [ms],P99 [ms]\n");
+	fflush(mFile);
+
+	return true;
+}
+
+void ADBDecodeLag::Stop()
+{
+	if (NULL == mFile) return;
+
+	WriteLine(std::chrono::duration<double>(std::chrono::steady_clock::now() - mStartTime).count());
+	fclose(mFile);
+	mFile = NULL;
+}
+
+void ADBDecodeLag::Update(U64 uiSample, bool bMoreAvailable)
+{
+	if (NULL == mFile) return;
+
+	double dElapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - mStartTime).count();
+	if (Measure(dElapsed, uiSample, bMoreAvailable))
+	{
+		mLagHistogram.Add(mLag);
+		if (mLag > mPeakLag) mPeakLag = mLag;
+	}
+
+	WriteLineIfDue(dElapsed);
+}
+
+void ADBDecodeLag::CaughtUp(U64 uiSample)
+{
+	if (NULL == mFile) return;
+
+	double dElapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - mStartTime).count();
+	Measure(dElapsed, uiSample, false);
+
+	WriteLineIfDue(dElapsed);
+}
+
+bool ADBDecodeLag::Measure(double dElapsed, U64 uiSample, bool bMoreAvailable)
+{
+	mSample = uiSample;
+
+	/* Estimated newest sample, relative to which decoding has reached (seconds) */
+	double dBehind = (dElapsed - mAnchorTime) - (double(uiSample) - double(mAnchorSample)) / double(mSampleRate);
+
+	if (!bMoreAvailable)
+	{
+		/* Caught up, a decoder ahead of the estimate shows where the channel actually ends */
+		if (dBehind < 0.0)
+		{
+			mAnchorSample = uiSample;
+			mAnchorTime = dElapsed;
+		}
+		mLagUnknown = false;
+		mLag = 0;
+	}
+	else if (dBehind < 0.0)
+	{
+		/* Ahead of the estimate with more to decode, capture began before decoding did */
+		mLagUnknown = true;
+	}
+	else
+	{
+		mLag = U64(dBehind * 1000000.0);
+	}
+
+	return !mLagUnknown;
+}
+
+void ADBDecodeLag::WriteLineIfDue(double dElapsed)
+{
+	if (dElapsed >= mNextLine)
+	{
+		WriteLine(dElapsed);
+		mNextLine = dElapsed + 1.0;
+	}
+}
+
+void ADBDecodeLag::WriteLine(double dElapsed)
+{
+	fprintf(mFile, "%.3f,%.6f,", dElapsed, double(mSample) / double(mSampleRate));
+
+	/* Current lag left empty while unknown, the rest until any lag is known */
+	if (!mLagUnknown) fprintf(mFile, "%.3f", double(mLag) / 1000.0);
+	if (mLagHistogram.GetCount() > 0)
+	{
+		fprintf(mFile, ",%.3f,%.3f,%.3f,%.3f\n",
+				double(mPeakLag) / 1000.0,
+				double(mLagHistogram.GetPercentile(50.0)) / 1000.0,
+				double(mLagHistogram.GetPercentile(90.0)) / 1000.0,
+				double(mLagHistogram.GetPercentile(99.0)) / 1000.0);
+	}
+	else
+	{
+		fprintf(mFile, ",,,,\n");
+	}
+	fflush(mFile);
+}
@@ -0,0 +1,85 @@
+#ifndef ADB_DECODE_LAG
+#define ADB_DECODE_LAG
+
+#pragma warning(push, 0)
+#include <chrono>
+#include <cstdio>
+#pragma warning(pop)
+
+#include <LogicPublicTypes.h>
+#include "ADBHistogram.h"
+
+/*
+** Measures how far decoding lags behind a capture being streamed, writing the
+** current, peak and percentile lag to a log file about once a second.
+**
+** The SDK doesn't report the newest sample captured, so it's estimated as
+** running on in real time from an anchor, at first the start of decoding,
+** taking the capture to have started then. Whenever the decoder has used
+** every transition the channel currently holds it has caught up, and the lag
+** is zero. That's checked between transactions as well as when they commit,
+** so a quiet bus shows the decoder caught up rather than the lag of the last
+** transaction. The percentiles are over committed transactions only.
+**
+** Decoding restarted part way through a stream starts behind a backlog, and
+** soon reaches samples beyond the estimate while the channel holds more. The
+** lag is then unknown, and logged empty, until decoding catches up. Catching
+** up beyond the estimate moves the anchor to where decoding reached, the
+** channel's actual extent, so later lag is measured from there.
+*/
+class ADBDecodeLag
+{
+	public:
+		ADBDecodeLag();
+		~ADBDecodeLag();
+
+		/* Start measuring for a decode, writing to log file (replacing it), returns false if it can't be created */
+		bool Start(const char* pszPath, U32 uiSampleRate, U64 uiStartSample);
+
+		/* Stop measuring, writing final line */
+		void Stop();
+
+		/* Measuring for this decode */
+		bool IsActive() const { return NULL != mFile; }
+
+		/* Record sample decoding has reached at a commit, and whether channel holds further transitions */
+		void Update(U64 uiSample, bool bMoreAvailable);
+
+		/* Record decoding has used every transition channel holds, reaching sample, between commits */
+		void CaughtUp(U64 uiSample);
+
+	protected:
+		/* Update current lag, returns false while unknown */
+		bool Measure(double dElapsed, U64 uiSample, bool bMoreAvailable);
+
+		/* Write line if one is due */
+		void WriteLineIfDue(double dElapsed);
+
+		/* Write current values to log */
+		void WriteLine(double dElapsed);
+
+		/* Log file */
+		FILE* mFile;
+
+		/* Configuration */
+		U32 mSampleRate;
+
+		/* When decoding began, and time of next log line (seconds after) */
+		std::chrono::steady_clock::time_point mStartTime;
+		double mNextLine;
+
+		/* Sample taken to be the newest captured at anchor time (seconds after start) */
+		U64 mAnchorSample;
+		double mAnchorTime;
+
+		/* Newest sample estimate is known to be too low, until decoding catches up */
+		bool mLagUnknown;
+
+		/* Latest and peak lag, and distribution (us) */
+		U64 mLag;
+		U64 mPeakLag;
+		U64 mSample;
+		ADBHistogram mLagHistogram;
+};
+
+#endif // ADB_DECODE_LAG
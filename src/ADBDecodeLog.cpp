@@ -0,0 +1,74 @@
+#pragma warning(push, 0)
+#include <algorithm>
+#pragma warning(pop)
+
+#include "ADBDecodeLog.h"
+
+ADBDecodeLog::ADBDecodeLog()
+	: mValid(false), mSampleRate(0), mMinPulseSamples(0)
+{
+}
+
+ADBDecodeLog::~ADBDecodeLog()
+{
+}
+
+void ADBDecodeLog::Reset(const Channel& channel, U32 uiSampleRate, U64 uiMinPulseSamples, const std::vector<U64>& auiLimits)
+{
+	mValid = true;
+	mChannel = channel;
+	mSampleRate = uiSampleRate;
+	mMinPulseSamples = uiMinPulseSamples;
+	mLimits = auiLimits;
+	mEvents.clear();
+	mSegments.clear();
+
+	/* Start with room for a typical capture, growth beyond is amortised */
+	mEvents.reserve(mEventsReserve);
+	mSegments.reserve(mSegmentsReserve);
+}
+
+void ADBDecodeLog::Invalidate()
+{
+	mValid = false;
+	mLimits.clear();
+
+	/* Release memory rather than just emptying */
+	std::vector<ADBDecodeEvent>().swap(mEvents);
+	std::vector<ADBDecodeSegment>().swap(mSegments);
+}
+
+bool ADBDecodeLog::IsCompatible(const Channel& channel, U32 uiSampleRate, U64 uiMinPulseSamples) const
+{
+	return (	mValid
+			 && (mChannel == channel)
+			 && (mSampleRate == uiSampleRate)
+			 && (mMinPulseSamples == uiMinPulseSamples)
+		   );
+}
+
+U64 ADBDecodeLog::GetLimitChange(const std::vector<U64>& auiLimits) const
+{
+	/* Limits don't correspond, treat as an infinite change */
+	if (auiLimits.size() != mLimits.size()) return UINT64_MAX;
+
+	U64 uiChange = 0;
+	for (size_t i = 0; i < mLimits.size(); i++)
+	{
+		U64 uiDiff = (auiLimits[i] > mLimits[i]) ? (auiLimits[i] - mLimits[i]) : (mLimits[i] - auiLimits[i]);
+		if (uiDiff > uiChange) uiChange = uiDiff;
+	}
+
+	return uiChange;
+}
+
+void ADBDecodeLog::Swap(ADBDecodeLog& other)
+{
+	std::swap(mValid, other.mValid);
+	std::swap(mChannel, other.mChannel);
+	std::swap(mSampleRate, other.mSampleRate);
+	std::swap(mMinPulseSamples, other.mMinPulseSamples);
+	mLimits.swap(other.mLimits);
+	mEvents.swap(other.mEvents);
+	mSegments.swap(other.mSegments);
+}
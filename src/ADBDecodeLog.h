@@ -0,0 +1,151 @@
+#ifndef ADB_DECODE_LOG
+#define ADB_DECODE_LOG
+
+#pragma warning(push, 0)
+#include <vector>
+#pragma warning(pop)
+
+#include <AnalyzerResults.h>
+
+/* Output produced by the decoder */
+enum ADBDecodeEventType
+{
+	/* Marker on waveform */
+	MarkerEvent,
+
+	/* Packet started (attention seen) */
+	PacketStartEvent,
+
+	/* Command or data byte frame */
+	ByteEvent,
+
+	/* Completed transaction */
+	TransactionEvent,
+
+	/* Transaction abandoned due to timing */
+	TimingViolationEvent,
+
+	/* Global reset */
+	GlobalResetEvent
+};
+
+/* Recorded decoder output, fields used depend upon type */
+struct ADBDecodeEvent
+{
+	/* Attention pulse starting transaction */
+	U64 uiAttention;
+
+	/* Marker location or start / end of byte / transaction */
+	U64 uiStart;
+	U64 uiEnd;
+
+	/* Event type */
+	U8 eType;
+
+	/* Marker type, byte value, command or abandoned state */
+	U8 uiValue;
+
+	/* Byte is data / service requested */
+	bool bIsData;
+	bool bServiceRequested;
+
+	/* Transaction data */
+	U8 uiDataLen;
+	U8 abyData[8];
+};
+
+/*
+** Span of capture between two transaction boundaries (where the decoder is in
+** its attention state having just committed a transaction), along with the
+** output decoded within it. Slack is the smallest distance in samples between
+** any period measured in the span and the limit it was compared against, the
+** span decodes identically as long as no limit moves by more than this.
+*/
+struct ADBDecodeSegment
+{
+	/* Reader location at start and end of span */
+	U64 uiStartSample;
+	U64 uiEndSample;
+
+	/* First edge after start, used to confirm the capture hasn't changed */
+	U64 uiFirstEdge;
+
+	/* Smallest distance of any measured period from its limit */
+	U64 uiSlack;
+
+	/* Output events (indexes into event list, end exclusive) */
+	size_t uiFirstEvent;
+	size_t uiEndEvent;
+};
+
+/*
+** Record of a decode, retained between runs such that a rerun with altered
+** timing tolerances can reuse the output of every segment which isn't affected
+** by the change, only decoding the remainder.
+**
+** The log duplicates everything output, so is dropped once its lists would
+** take more than mMaxBytes, that decode then being unable to be reused.
+*/
+class ADBDecodeLog
+{
+	public:
+		ADBDecodeLog();
+		~ADBDecodeLog();
+
+		/* Discard everything and start a log for a decode with the given configuration and limits */
+		void Reset(const Channel& channel, U32 uiSampleRate, U64 uiMinPulseSamples, const std::vector<U64>& auiLimits);
+
+		/* Discard everything, log becomes unusable */
+		void Invalidate();
+
+		/* Check log was produced from the same channel, sample rate and edge filtering */
+		bool IsCompatible(const Channel& channel, U32 uiSampleRate, U64 uiMinPulseSamples) const;
+
+		/* Largest change in any limit, from those the log was recorded with */
+		U64 GetLimitChange(const std::vector<U64>& auiLimits) const;
+
+		/* Most memory event and segment lists may take */
+		static const size_t mMaxBytes = 64 * 1024 * 1024;
+
+		/* Check whether log is usable */
+		bool IsValid() const { return mValid; }
+
+		/* Record output (ignored if log is unusable) */
+		void AddEvent(const ADBDecodeEvent& event) { if (mValid) { mEvents.push_back(event); CheckSize(); } }
+		size_t GetNumEvents() const { return mEvents.size(); }
+		const ADBDecodeEvent& GetEvent(size_t uiIndex) const { return mEvents[uiIndex]; }
+
+		/* Record completed segment */
+		void AddSegment(const ADBDecodeSegment& segment) { if (mValid) { mSegments.push_back(segment); CheckSize(); } }
+		size_t GetNumSegments() const { return mSegments.size(); }
+		const ADBDecodeSegment& GetSegment(size_t uiIndex) const { return mSegments[uiIndex]; }
+
+		/* Exchange contents with another log */
+		void Swap(ADBDecodeLog& other);
+
+	protected:
+		/* Drop log if lists have grown beyond limit */
+		void CheckSize()
+		{
+			if (((mEvents.capacity() * sizeof(ADBDecodeEvent)) + (mSegments.capacity() * sizeof(ADBDecodeSegment))) > mMaxBytes) Invalidate();
+		}
+
+		/* Configuration log was recorded with */
+		bool mValid;
+		Channel mChannel;
+		U32 mSampleRate;
+		U64 mMinPulseSamples;
+
+		/* Sample count limits log was recorded with */
+		std::vector<U64> mLimits;
+
+		/* Initial capacity of event and segment lists */
+		static const size_t mEventsReserve = 4096;
+		static const size_t mSegmentsReserve = 512;
+
+		/* Output events and segments they belong to */
+		std::vector<ADBDecodeEvent> mEvents;
+		std::vector<ADBDecodeSegment> mSegments;
+};
+
+#endif // ADB_DECODE_LOG
@@ -0,0 +1,65 @@
+#include "ADBEdgeReader.h"
+
+ADBEdgeReader::ADBEdgeReader()
+	: mChannel(NULL), mMinPulseSamples(0), mSample(0), mBitState(BIT_HIGH), mNextEdge(0), mNextEdgeValid(false), mGlitchCount(0)
+{
+}
+
+ADBEdgeReader::~ADBEdgeReader()
+{
+}
+
+void ADBEdgeReader::Initialize(AnalyzerChannelData* pChannel, U64 uiMinPulseSamples)
+{
+	mChannel = pChannel;
+	mMinPulseSamples = uiMinPulseSamples;
+	mSample = mChannel->GetSampleNumber();
+	mBitState = mChannel->GetBitState();
+	mNextEdgeValid = false;
+	mGlitchCount = 0;
+}
+
+void ADBEdgeReader::Seek(U64 uiSample)
+{
+	/* Channel may already be sat on the next edge, only ever move it forwards */
+	if (uiSample > mChannel->GetSampleNumber())
+	{
+		mChannel->AdvanceToAbsPosition(uiSample);
+	}
+
+	/* Accepted edges always coincide with a channel edge, so the channel state is ours */
+	mSample = uiSample;
+	mBitState = mChannel->GetBitState();
+	mNextEdgeValid = false;
+}
+
+void ADBEdgeReader::FindNextEdge()
+{
+	for (;;)
+	{
+		/* Step the channel onto the candidate edge */
+		mChannel->AdvanceToNextEdge();
+		U64 edge_location = mChannel->GetSampleNumber();
+
+		if (0 == mMinPulseSamples)
+		{
+			/* Filter disabled, every edge is accepted */
+			mNextEdge = edge_location;
+			break;
+		}
+
+		/* Candidate is accepted unless the channel returns to the current state too quickly */
+		U64 return_location = mChannel->GetSampleOfNextEdge();
+		if ((return_location - edge_location) >= mMinPulseSamples)
+		{
+			mNextEdge = edge_location;
+			break;
+		}
+
+		/* Glitch, skip the return edge such that the channel state matches ours again */
+		mChannel->AdvanceToNextEdge();
+		mGlitchCount++;
+	}
+
+	mNextEdgeValid = true;
+}
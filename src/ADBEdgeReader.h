@@ -0,0 +1,76 @@
+#ifndef ADB_EDGE_READER
+#define ADB_EDGE_READER
+
+#include <AnalyzerChannelData.h>
+
+/*
+** Edge iterator placed between the channel data and the decoder state machine.
+** When a minimum pulse width is set, pulses shorter than it are treated as if
+** they never happened, merging the periods either side of them. Only a single
+** edge of lookahead is held, the underlying channel is advanced to the next
+** accepted edge as soon as it has been found.
+*/
+class ADBEdgeReader
+{
+	public:
+		ADBEdgeReader();
+		~ADBEdgeReader();
+
+		/* Attach to channel, pulses shorter than min pulse samples are suppressed (zero to disable) */
+		void Initialize(AnalyzerChannelData* pChannel, U64 uiMinPulseSamples);
+
+		/* Current location and state */
+		U64 GetSampleNumber() { return mSample; }
+		BitState GetBitState() { return mBitState; }
+
+		/* Location of next accepted edge (without advancing) */
+		U64 GetSampleOfNextEdge()
+		{
+			if (!mNextEdgeValid) FindNextEdge();
+			return mNextEdge;
+		}
+
+		/* Advance to next accepted edge */
+		void AdvanceToNextEdge()
+		{
+			if (!mNextEdgeValid) FindNextEdge();
+			mSample = mNextEdge;
+			mBitState = (BIT_HIGH == mBitState) ? BIT_LOW : BIT_HIGH;
+			mNextEdgeValid = false;
+		}
+
+		/* Move forward to a location previously reached through AdvanceToNextEdge() */
+		void Seek(U64 uiSample);
+
+		/* Number of suppressed pulses */
+		U64 GetGlitchCount() { return mGlitchCount; }
+
+		/* Furthest location seen, including next edge if it has been looked ahead to */
+		U64 GetFurthestSampleNumber() { return mNextEdgeValid ? mNextEdge : mSample; }
+
+		/* Check whether channel already holds edges beyond the furthest sample (without waiting for more to be captured) */
+		bool MoreEdgesAvailable() { return mChannel->DoMoreTransitionsExistInCurrentData(); }
+
+	protected:
+		/* Locate next edge which isn't part of a glitch, leaving the channel sat on it */
+		void FindNextEdge();
+
+		/* Source channel */
+		AnalyzerChannelData* mChannel;
+
+		/* Pulses shorter than this are suppressed */
+		U64 mMinPulseSamples;
+
+		/* Current location and state */
+		U64 mSample;
+		BitState mBitState;
+
+		/* Next accepted edge, if found */
+		U64 mNextEdge;
+		bool mNextEdgeValid;
+
+		/* Number of suppressed pulses */
+		U64 mGlitchCount;
+};
+
+#endif // ADB_EDGE_READER
@@ -0,0 +1,132 @@
+#include "ADBExportCompressor.h"
+
+#ifdef ADB_HAVE_ZLIB
+
+#pragma warning(push, 0)
+#include <cstring>
+#pragma warning(pop)
+
+#include <AnalyzerHelpers.h>
+
+/* Size of compressed output written at a time */
+#define ADB_COMPRESSED_OUTPUT_SIZE (64 * 1024)
+
+ADBExportCompressor::ADBExportCompressor()
+	: mFile(NULL), mError(false), mFinishing(false)
+{
+	memset(&mStream, 0, sizeof(mStream));
+}
+
+ADBExportCompressor::~ADBExportCompressor()
+{
+	if (mThread.joinable()) Finish();
+}
+
+bool ADBExportCompressor::Start(void* f)
+{
+	/* Window bits of 15 + 16 selects a gzip header */
+	memset(&mStream, 0, sizeof(mStream));
+	if (Z_OK != deflateInit2(&mStream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY)) return false;
+
+	mFile = f;
+	mOutput.resize(ADB_COMPRESSED_OUTPUT_SIZE);
+	mError = false;
+	mFinishing = false;
+	mThread = std::thread(&ADBExportCompressor::CompressorThread, this);
+
+	return true;
+}
+
+void ADBExportCompressor::Write(std::string& block)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	/* Wait for room */
+	mCondition.wait(lock, [this] { return mQueue.size() < mMaxQueuedBlocks; });
+
+	/* Take block, leaving it a reused one */
+	mQueue.push_back(std::string());
+	mQueue.back().swap(block);
+	if (!mFree.empty())
+	{
+		block.swap(mFree.back());
+		mFree.pop_back();
+	}
+	lock.unlock();
+
+	mCondition.notify_all();
+}
+
+bool ADBExportCompressor::Finish()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mFinishing = true;
+	}
+	mCondition.notify_all();
+	mThread.join();
+
+	deflateEnd(&mStream);
+
+	return !mError;
+}
+
+void ADBExportCompressor::CompressorThread()
+{
+	std::string block;
+
+	for (;;)
+	{
+		/* Next block, unless finished */
+		std::unique_lock<std::mutex> lock(mMutex);
+		mCondition.wait(lock, [this] { return mFinishing || !mQueue.empty(); });
+		if (mQueue.empty()) break;
+
+		block.swap(mQueue.front());
+		mQueue.pop_front();
+		lock.unlock();
+		mCondition.notify_all();
+
+		Deflate(block, Z_NO_FLUSH);
+
+		/* Return block for reuse */
+		block.clear();
+		lock.lock();
+		if (mFree.size() < mMaxQueuedBlocks)
+		{
+			mFree.push_back(std::string());
+			mFree.back().swap(block);
+		}
+	}
+
+	/* End stream */
+	Deflate(std::string(), Z_FINISH);
+}
+
+void ADBExportCompressor::Deflate(const std::string& data, int iFlush)
+{
+	/* Nothing more is written once compression has failed */
+	if (mError) return;
+
+	mStream.next_in = (Bytef*)data.c_str();
+	mStream.avail_in = uInt(data.size());
+
+	/* Compress until output is no longer filled */
+	do
+	{
+		mStream.next_out = &mOutput[0];
+		mStream.avail_out = uInt(mOutput.size());
+
+		if (Z_STREAM_ERROR == deflate(&mStream, iFlush))
+		{
+			mError = true;
+			return;
+		}
+
+		U32 uiLength = U32(mOutput.size() - mStream.avail_out);
+		if (uiLength > 0) AnalyzerHelpers::AppendToFile(&mOutput[0], uiLength, mFile);
+	}
+	while (0 == mStream.avail_out);
+}
+
+#endif // ADB_HAVE_ZLIB
@@ -0,0 +1,68 @@
+#ifndef ADB_EXPORT_COMPRESSOR
+#define ADB_EXPORT_COMPRESSOR
+
+#ifdef ADB_HAVE_ZLIB
+
+#pragma warning(push, 0)
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+#pragma warning(pop)
+
+#include <LogicPublicTypes.h>
+
+/*
+** Gzip compresses export output on its own thread, so formatting carries on
+** while earlier output is compressed and written. Blocks are handed over in a
+** bounded queue, formatting waiting only when the queue is full, so memory use
+** depends on block size rather than capture size.
+*/
+class ADBExportCompressor
+{
+	public:
+		ADBExportCompressor();
+		~ADBExportCompressor();
+
+		/* Most blocks queued for compression */
+		static const size_t mMaxQueuedBlocks = 4;
+
+		/* Start compressing to file, returns false if compression can't be set up */
+		bool Start(void* f);
+
+		/* Queue block, taking its contents (block is left empty, possibly with capacity of an earlier one) */
+		void Write(std::string& block);
+
+		/* Compress everything queued and end stream, returns false if compression failed */
+		bool Finish();
+
+	protected:
+		/* Compress queued blocks until finished */
+		void CompressorThread();
+
+		/* Compress data, writing output to file */
+		void Deflate(const std::string& data, int iFlush);
+
+		/* Output file and compressor state */
+		void* mFile;
+		z_stream mStream;
+		std::vector<U8> mOutput;
+		bool mError;
+
+		/* Blocks to compress, and emptied blocks to reuse */
+		std::deque<std::string> mQueue;
+		std::vector<std::string> mFree;
+		bool mFinishing;
+
+		/* Compressor thread, guarding of queues */
+		std::thread mThread;
+		std::mutex mMutex;
+		std::condition_variable mCondition;
+};
+
+#endif // ADB_HAVE_ZLIB
+
+#endif // ADB_EXPORT_COMPRESSOR
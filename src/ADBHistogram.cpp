@@ -0,0 +1,98 @@
+#pragma warning(push, 0)
+#include <cstring>
+#pragma warning(pop)
+
+#include "ADBHistogram.h"
+
+ADBHistogram::ADBHistogram()
+{
+	Clear();
+}
+
+ADBHistogram::~ADBHistogram()
+{
+}
+
+void ADBHistogram::Clear()
+{
+	memset(mBuckets, 0, sizeof(mBuckets));
+	mCount = 0;
+	mSum = 0;
+	mMin = UINT64_MAX;
+	mMax = 0;
+}
+
+void ADBHistogram::Add(U64 uiValue, U64 uiCount)
+{
+	if (0 == uiCount) return;
+
+	mBuckets[GetBucket(uiValue)] += uiCount;
+	mCount += uiCount;
+	mSum += uiValue * uiCount;
+	if (uiValue < mMin) mMin = uiValue;
+	if (uiValue > mMax) mMax = uiValue;
+}
+
+U64 ADBHistogram::GetPercentile(double dPercent) const
+{
+	if (0 == mCount) return 0;
+
+	/* Number of values which must be covered, at least one */
+	U64 uiRank = U64((dPercent / 100.0) * double(mCount) + 0.5);
+	if (uiRank < 1) uiRank = 1;
+	if (uiRank > mCount) uiRank = mCount;
+
+	U64 uiSeen = 0;
+	for (U32 i = 0; i < mNumBuckets; i++)
+	{
+		uiSeen += mBuckets[i];
+		if (uiSeen >= uiRank)
+		{
+			/* Bucket bound, limited to the range actually seen */
+			U64 uiValue = GetBucketHigh(i);
+			if (uiValue > mMax) uiValue = mMax;
+			if (uiValue < mMin) uiValue = mMin;
+			return uiValue;
+		}
+	}
+
+	return mMax;
+}
+
+U64 ADBHistogram::GetBucketLow(U32 uiBucket)
+{
+	if (uiBucket < mLinearLimit) return uiBucket;
+
+	U32 uiLog = uiBucket - U32(mLinearLimit);
+	U32 uiExponent = 7 + (uiLog >> mSubBucketBits);
+	U64 uiSub = uiLog & ((1 << mSubBucketBits) - 1);
+
+	return ((U64(1) << mSubBucketBits) + uiSub) << (uiExponent - mSubBucketBits);
+}
+
+U64 ADBHistogram::GetBucketHigh(U32 uiBucket)
+{
+	if (uiBucket < mLinearLimit) return uiBucket;
+
+	/* Last bucket also holds everything beyond it */
+	if (uiBucket == (mNumBuckets - 1)) return UINT64_MAX;
+
+	return GetBucketLow(uiBucket + 1) - 1;
+}
+
+U32 ADBHistogram::GetBucket(U64 uiValue)
+{
+	if (uiValue < mLinearLimit) return U32(uiValue);
+
+	/* Beyond largest power of two, count in last bucket */
+	if (uiValue >= (U64(2) << mMaxExponent)) return mNumBuckets - 1;
+
+	/* Locate most significant bit, linear limit is 2^7 */
+	U32 uiExponent = 7;
+	while ((uiValue >> (uiExponent + 1)) != 0) uiExponent++;
+
+	/* Next bits below it select the sub bucket */
+	U32 uiSub = U32(uiValue >> (uiExponent - mSubBucketBits)) & ((1 << mSubBucketBits) - 1);
+
+	return U32(mLinearLimit) + ((uiExponent - 7) << mSubBucketBits) + uiSub;
+}
@@ -0,0 +1,64 @@
+#ifndef ADB_HISTOGRAM
+#define ADB_HISTOGRAM
+
+#include <LogicPublicTypes.h>
+
+/*
+** Fixed size histogram of unsigned values. Values below the linear limit have
+** a bucket each, above it every power of two is split into sixteen buckets,
+** keeping the error of any reported percentile within 1/16th of its value.
+** Values beyond the largest bucket are counted in it.
+*/
+class ADBHistogram
+{
+	public:
+		ADBHistogram();
+		~ADBHistogram();
+
+		/* Values below this are counted exactly */
+		static const U64 mLinearLimit = 128;
+
+		/* Buckets per power of two above the linear limit */
+		static const U32 mSubBucketBits = 4;
+
+		/* Largest power of two covered */
+		static const U32 mMaxExponent = 40;
+
+		/* Total number of buckets */
+		static const U32 mNumBuckets = U32(mLinearLimit) + ((mMaxExponent - 7 + 1) << mSubBucketBits);
+
+		/* Discard all values */
+		void Clear();
+
+		/* Count value, number of times */
+		void Add(U64 uiValue, U64 uiCount = 1);
+
+		/* Number of values, smallest, largest and mean */
+		U64 GetCount() const { return mCount; }
+		U64 GetMin() const { return mCount ? mMin : 0; }
+		U64 GetMax() const { return mMax; }
+		double GetMean() const { return mCount ? (double(mSum) / double(mCount)) : 0.0; }
+
+		/* Smallest value at least given percent of values are less than or equal to (upper bound of its bucket) */
+		U64 GetPercentile(double dPercent) const;
+
+		/* Bucket contents and the range of values it covers (inclusive) */
+		U64 GetBucketCount(U32 uiBucket) const { return mBuckets[uiBucket]; }
+		static U64 GetBucketLow(U32 uiBucket);
+		static U64 GetBucketHigh(U32 uiBucket);
+
+	protected:
+		/* Locate bucket covering value */
+		static U32 GetBucket(U64 uiValue);
+
+		/* Values per bucket */
+		U64 mBuckets[mNumBuckets];
+
+		/* Summary */
+		U64 mCount;
+		U64 mSum;
+		U64 mMin;
+		U64 mMax;
+};
+
+#endif // ADB_HISTOGRAM
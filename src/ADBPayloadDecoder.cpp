@@ -0,0 +1,142 @@
+#pragma warning(push, 0)
+#include <cstdio>
+#pragma warning(pop)
+
+#include "ADBPayloadDecoder.h"
+#include "ADBAnalyzer.h"
+
+#pragma warning(disable : 4996) // warning C4996: 'snprintf': This function or variable may be unsafe.
+
+/* Keyboard key code reported when no key transition is present */
+#define KEYBOARD_NO_KEY 0xff
+
+/* Key up flag in keyboard key code byte */
+#define KEYBOARD_KEY_UP ( 1 << 7 )
+
+/* Button up flag in mouse data bytes */
+#define MOUSE_BUTTON_UP ( 1 << 7 )
+
+/* Register 3 fields */
+#define REG3_EXCEPTIONAL_EVENT ( 1 << 6 )
+#define REG3_SRQ_ENABLE ( 1 << 5 )
+#define REG3_ADDR_MASK 0x0f
+
+bool ADBPayloadDecoder::Decode(U8 byCommand, const U8 *pabyData, U8 uiDataLen, char *pszOutput, U32 uiOutputLen)
+{
+	/* Decode command */
+	U8 uiAddr = ((byCommand >> ADBAnalyzer::mADBCommandAddrShift) & ADBAnalyzer::mADBCommandAddrMask);
+	ADBCommand eCode = ADBCommand((byCommand >> ADBAnalyzer::mADBCommandCodeShift) & ADBAnalyzer::mADBCommandCodeMask);
+	U8 uiReg = ((byCommand >> ADBAnalyzer::mADBCommandRegShift) & ADBAnalyzer::mADBCommandRegMask);
+
+	/* Assume nothing to say */
+	pszOutput[0] = '\0';
+
+	/* All understood payloads carry at least two bytes */
+	if (uiDataLen < 2) return false;
+
+	if ((3 == uiReg) && ((Talk == eCode) || (Listen == eCode)))
+	{
+		DecodeRegister3((Listen == eCode), pabyData, pszOutput, uiOutputLen);
+		return true;
+	}
+
+	if ((0 == uiReg) && (Talk == eCode) && (mKeyboardAddr == uiAddr))
+	{
+		DecodeKeyboard(pabyData, uiDataLen, pszOutput, uiOutputLen);
+		return true;
+	}
+
+	if ((0 == uiReg) && (Talk == eCode) && (mMouseAddr == uiAddr))
+	{
+		DecodeMouse(pabyData, pszOutput, uiOutputLen);
+		return true;
+	}
+
+	return false;
+}
+
+void ADBPayloadDecoder::DecodeKeyboard(const U8 *pabyData, U8 uiDataLen, char *pszOutput, U32 uiOutputLen)
+{
+	/* Power key is reported as 0x7f 0x7f (down) or 0xff 0xff (up) */
+	if ((0x7f == (pabyData[0] & 0x7f)) && (pabyData[0] == pabyData[1]))
+	{
+		snprintf(pszOutput, uiOutputLen, "power %s", (pabyData[0] & KEYBOARD_KEY_UP) ? "up" : "down");
+		return;
+	}
+
+	/* Each of the first two bytes holds a key transition, or no key */
+	U32 uiUsed = 0;
+	for (int i = 0; (i < 2) && (i < uiDataLen); i++)
+	{
+		if (KEYBOARD_NO_KEY == pabyData[i]) continue;
+
+		int iLen = snprintf(&pszOutput[uiUsed], uiOutputLen - uiUsed, "%skey 0x%02x %s",
+							(uiUsed > 0) ? ", " : "",
+							pabyData[i] & ~KEYBOARD_KEY_UP,
+							(pabyData[i] & KEYBOARD_KEY_UP) ? "up" : "down");
+		if ((iLen < 0) || (U32(iLen) >= (uiOutputLen - uiUsed))) break;
+		uiUsed += iLen;
+	}
+}
+
+void ADBPayloadDecoder::DecodeMouse(const U8 *pabyData, char *pszOutput, U32 uiOutputLen)
+{
+	/* Button state is active low, in the Y byte, motion is 7 bit two's complement */
+	snprintf(pszOutput, uiOutputLen, "button %s dx %+d dy %+d",
+			 (pabyData[0] & MOUSE_BUTTON_UP) ? "up" : "down",
+			 SignExtend7(pabyData[1]),
+			 SignExtend7(pabyData[0]));
+}
+
+void ADBPayloadDecoder::DecodeRegister3(bool bIsListen, const U8 *pabyData, char *pszOutput, U32 uiOutputLen)
+{
+	U8 uiNewAddr = (pabyData[0] & REG3_ADDR_MASK);
+	U8 uiHandler = pabyData[1];
+
+	if (!bIsListen)
+	{
+		/* Device reporting its address and handler */
+		snprintf(pszOutput, uiOutputLen, "addr %u handler 0x%02x%s%s",
+				 uiNewAddr,
+				 uiHandler,
+				 (pabyData[0] & REG3_SRQ_ENABLE) ? " srq_en" : "",
+				 (pabyData[0] & REG3_EXCEPTIONAL_EVENT) ? " exc_event" : "");
+		return;
+	}
+
+	/* Host changing address and / or handler, some handler values are reserved commands */
+	switch (uiHandler)
+	{
+		case 0x00:
+		{
+			snprintf(pszOutput, uiOutputLen, "set addr %u", uiNewAddr);
+			break;
+		}
+		case 0xfd:
+		{
+			snprintf(pszOutput, uiOutputLen, "set addr %u if activator pressed", uiNewAddr);
+			break;
+		}
+		case 0xfe:
+		{
+			snprintf(pszOutput, uiOutputLen, "set addr %u if no collision", uiNewAddr);
+			break;
+		}
+		case 0xff:
+		{
+			snprintf(pszOutput, uiOutputLen, "self test");
+			break;
+		}
+		default:
+		{
+			snprintf(pszOutput, uiOutputLen, "set addr %u handler 0x%02x", uiNewAddr, uiHandler);
+			break;
+		}
+	}
+}
+
+int ADBPayloadDecoder::SignExtend7(U8 byValue)
+{
+	byValue &= 0x7f;
+	return (byValue & 0x40) ? (int(byValue) - 0x80) : int(byValue);
+}
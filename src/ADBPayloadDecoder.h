@@ -0,0 +1,38 @@
+#ifndef ADB_PAYLOAD_DECODER
+#define ADB_PAYLOAD_DECODER
+
+#include <LogicPublicTypes.h>
+
+/*
+** Second stage decoding of standard device payloads. Devices are identified by
+** their power on default address, so a keyboard or mouse which has been moved
+** to another address is only decoded through its register 3 traffic.
+*/
+class ADBPayloadDecoder
+{
+	public:
+		/* Default device addresses */
+		static const U8 mKeyboardAddr = 2;
+		static const U8 mMouseAddr = 3;
+
+		/*
+		** Describe payload of a transaction, returns false (and an empty string)
+		** if the payload isn't one which is understood
+		*/
+		static bool Decode(U8 byCommand, const U8 *pabyData, U8 uiDataLen, char *pszOutput, U32 uiOutputLen);
+
+	protected:
+		/* Keyboard register 0, up to two key transitions */
+		static void DecodeKeyboard(const U8 *pabyData, U8 uiDataLen, char *pszOutput, U32 uiOutputLen);
+
+		/* Mouse register 0, button and relative motion */
+		static void DecodeMouse(const U8 *pabyData, char *pszOutput, U32 uiOutputLen);
+
+		/* Register 3, address and handler ID */
+		static void DecodeRegister3(bool bIsListen, const U8 *pabyData, char *pszOutput, U32 uiOutputLen);
+
+		/* Sign extend 7 bit motion value */
+		static int SignExtend7(U8 byValue);
+};
+
+#endif // ADB_PAYLOAD_DECODER
@@ -0,0 +1,85 @@
+#pragma warning(push, 0)
+#include <algorithm>
+#include <cstring>
+#pragma warning(pop)
+
+#include "ADBRegisterTimeline.h"
+#include "ADBAnalyzer.h"
+
+/* Order change against sample, for binary search */
+static bool SampleBeforeChange(U64 uiSample, const ADBRegisterChange& change)
+{
+	return uiSample < change.uiSample;
+}
+
+ADBRegisterTimeline::ADBRegisterTimeline()
+{
+}
+
+ADBRegisterTimeline::~ADBRegisterTimeline()
+{
+}
+
+void ADBRegisterTimeline::Reset()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	for (U32 i = 0; i < (ADB_NUM_ADDRESSES * ADB_NUM_REGISTERS); i++)
+	{
+		mChanges[i].clear();
+	}
+}
+
+void ADBRegisterTimeline::AddTransaction(U8 byCommand, const U8 *pabyData, U8 uiDataLen, U64 uiEnd)
+{
+	/* Decode command */
+	U8 uiAddr = ((byCommand >> ADBAnalyzer::mADBCommandAddrShift) & ADBAnalyzer::mADBCommandAddrMask);
+	ADBCommand eCode = ADBCommand((byCommand >> ADBAnalyzer::mADBCommandCodeShift) & ADBAnalyzer::mADBCommandCodeMask);
+	U8 uiReg = ((byCommand >> ADBAnalyzer::mADBCommandRegShift) & ADBAnalyzer::mADBCommandRegMask);
+
+	/* Only talk and listen carrying data transfer a register value */
+	if (((Talk != eCode) && (Listen != eCode)) || (0 == uiDataLen)) return;
+	if (uiDataLen > 8) uiDataLen = 8;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	std::vector<ADBRegisterChange>& changes = mChanges[(uiAddr * ADB_NUM_REGISTERS) + uiReg];
+
+	/* Unchanged */
+	if (	!changes.empty()
+		 && (changes.back().uiDataLen == uiDataLen)
+		 && (0 == memcmp(changes.back().abyData, pabyData, uiDataLen))
+	   )
+	{
+		return;
+	}
+
+	ADBRegisterChange change;
+	change.uiSample = uiEnd;
+	change.uiDataLen = uiDataLen;
+	memset(change.abyData, 0, sizeof(change.abyData));
+	memcpy(change.abyData, pabyData, uiDataLen);
+	change.bListen = (Listen == eCode);
+	changes.push_back(change);
+}
+
+bool ADBRegisterTimeline::GetValueAt(U8 uiAddr, U8 uiReg, U64 uiSample, ADBRegisterChange* pChange)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	const std::vector<ADBRegisterChange>& changes = mChanges[(uiAddr * ADB_NUM_REGISTERS) + uiReg];
+
+	/* Last change at or before sample */
+	std::vector<ADBRegisterChange>::const_iterator it = std::upper_bound(changes.begin(), changes.end(), uiSample, SampleBeforeChange);
+	if (changes.begin() == it) return false;
+
+	*pChange = *(it - 1);
+	return true;
+}
+
+void ADBRegisterTimeline::GetChanges(U8 uiAddr, U8 uiReg, std::vector<ADBRegisterChange>* pChanges)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	*pChanges = mChanges[(uiAddr * ADB_NUM_REGISTERS) + uiReg];
+}
@@ -0,0 +1,61 @@
+#ifndef ADB_REGISTER_TIMELINE
+#define ADB_REGISTER_TIMELINE
+
+#pragma warning(push, 0)
+#include <mutex>
+#include <vector>
+#pragma warning(pop)
+
+#include <LogicPublicTypes.h>
+#include "ADBBusAnalytics.h"
+
+/* Number of registers of each device */
+#define ADB_NUM_REGISTERS 4
+
+/* Value of a device register from a given point in the capture */
+struct ADBRegisterChange
+{
+	/* End of transaction value was seen in */
+	U64 uiSample;
+
+	/* Value */
+	U8 uiDataLen;
+	U8 abyData[8];
+
+	/* Seen in a listen (host write) rather than a talk (device read) */
+	bool bListen;
+};
+
+/*
+** Values of every device register over the capture, from the data of talk and
+** listen transactions. Only changes are kept, in decode (and so sample) order,
+** a value being located by binary search. Updated by the worker thread and read
+** when exporting.
+*/
+class ADBRegisterTimeline
+{
+	public:
+		ADBRegisterTimeline();
+		~ADBRegisterTimeline();
+
+		/* Discard everything */
+		void Reset();
+
+		/* Record register value of completed transaction, if it carried data and it differs from the last */
+		void AddTransaction(U8 byCommand, const U8 *pabyData, U8 uiDataLen, U64 uiEnd);
+
+		/* Value of register at sample, returns false if none has been seen by then */
+		bool GetValueAt(U8 uiAddr, U8 uiReg, U64 uiSample, ADBRegisterChange* pChange);
+
+		/* Copy changes of register */
+		void GetChanges(U8 uiAddr, U8 uiReg, std::vector<ADBRegisterChange>* pChanges);
+
+	protected:
+		/* Changes of each register, indexed by address and register */
+		std::vector<ADBRegisterChange> mChanges[ADB_NUM_ADDRESSES * ADB_NUM_REGISTERS];
+
+		/* Export may read while the worker thread updates */
+		std::mutex mMutex;
+};
+
+#endif // ADB_REGISTER_TIMELINE
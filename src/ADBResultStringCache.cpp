@@ -0,0 +1,84 @@
+#include "ADBResultStringCache.h"
+
+ADBResultStringCache::ADBResultStringCache(size_t uiCapacity)
+	: mCapacity(uiCapacity), mDisplayBase(Hexadecimal)
+{
+}
+
+ADBResultStringCache::~ADBResultStringCache()
+{
+}
+
+bool ADBResultStringCache::Lookup(ADBResultStringKind eKind, U64 uiIndex, DisplayBase eDisplayBase, std::string& strOutput)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	/* Entries in a different display base are of no use */
+	SelectDisplayBase(eDisplayBase);
+
+	Key key = {eKind, uiIndex};
+	auto it = mIndex.find(key);
+	if (it == mIndex.end())
+	{
+		/* Miss */
+		return false;
+	}
+
+	/* Hit, move entry to front of list as most recently used */
+	mEntries.splice(mEntries.begin(), mEntries, it->second);
+	strOutput = it->second->second;
+
+	return true;
+}
+
+void ADBResultStringCache::Insert(ADBResultStringKind eKind, U64 uiIndex, DisplayBase eDisplayBase, const std::string& strValue)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	SelectDisplayBase(eDisplayBase);
+
+	Key key = {eKind, uiIndex};
+	auto it = mIndex.find(key);
+	if (it != mIndex.end())
+	{
+		/* Already present (formatted by another thread), refresh it */
+		it->second->second = strValue;
+		mEntries.splice(mEntries.begin(), mEntries, it->second);
+		return;
+	}
+
+	if (mEntries.size() >= mCapacity)
+	{
+		/* Full, evict least recently used entry, reusing its node */
+		EntryList::iterator last = std::prev(mEntries.end());
+		mIndex.erase(last->first);
+		last->first = key;
+		last->second = strValue;
+		mEntries.splice(mEntries.begin(), mEntries, last);
+	}
+	else
+	{
+		mEntries.emplace_front(key, strValue);
+	}
+
+	mIndex[key] = mEntries.begin();
+}
+
+void ADBResultStringCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	mEntries.clear();
+	mIndex.clear();
+}
+
+void ADBResultStringCache::SelectDisplayBase(DisplayBase eDisplayBase)
+{
+	if (eDisplayBase != mDisplayBase)
+	{
+		/* Display base changed, invalidate everything */
+		mEntries.clear();
+		mIndex.clear();
+		mDisplayBase = eDisplayBase;
+	}
+}
@@ -0,0 +1,82 @@
+#ifndef ADB_RESULT_STRING_CACHE
+#define ADB_RESULT_STRING_CACHE
+
+#pragma warning(push, 0)
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#pragma warning(pop)
+
+#include <AnalyzerResults.h>
+
+/* Kinds of formatted string held in the cache */
+enum ADBResultStringKind
+{
+	/* Bubble text for a frame */
+	BubbleString,
+
+	/* Tabular text for a frame */
+	FrameTabularString,
+
+	/* Tabular text for a packet */
+	PacketTabularString,
+
+	/* Decoded device payload of a packet */
+	PayloadString
+};
+
+/*
+** Bounded least recently used cache of formatted result strings, keyed by
+** string kind and frame / packet index. All entries are formatted in a single
+** display base, changing the display base empties the cache.
+*/
+class ADBResultStringCache
+{
+	public:
+		ADBResultStringCache(size_t uiCapacity);
+		~ADBResultStringCache();
+
+		/* Retrieve cached string, returns false on miss */
+		bool Lookup(ADBResultStringKind eKind, U64 uiIndex, DisplayBase eDisplayBase, std::string& strOutput);
+
+		/* Insert string, evicting least recently used entry when full */
+		void Insert(ADBResultStringKind eKind, U64 uiIndex, DisplayBase eDisplayBase, const std::string& strValue);
+
+		/* Remove all entries */
+		void Clear();
+
+	protected:
+		struct Key
+		{
+			ADBResultStringKind eKind;
+			U64 uiIndex;
+
+			bool operator==(const Key& other) const { return (eKind == other.eKind) && (uiIndex == other.uiIndex); }
+		};
+
+		struct KeyHash
+		{
+			size_t operator()(const Key& key) const { return std::hash<U64>()((key.uiIndex << 2) | key.eKind); }
+		};
+
+		typedef std::list<std::pair<Key, std::string> > EntryList;
+
+		/* Switch display base, dropping entries formatted in the old base (lock must be held) */
+		void SelectDisplayBase(DisplayBase eDisplayBase);
+
+		/* Maximum number of entries */
+		size_t mCapacity;
+
+		/* Display base of all cached entries */
+		DisplayBase mDisplayBase;
+
+		/* Entries ordered most to least recently used, plus index into the list */
+		EntryList mEntries;
+		std::unordered_map<Key, EntryList::iterator, KeyHash> mIndex;
+
+		/* Results may be requested from multiple UI threads */
+		std::mutex mMutex;
+};
+
+#endif // ADB_RESULT_STRING_CACHE
@@ -1,5 +1,7 @@
 #include "ADBSimulationDataGenerator.h"
 #include "ADBAnalyzerSettings.h"
+#include <sstream>
+#include <cstdlib>
 
 /* Sample data frame */
 const U8 ADBSimulationDataGenerator::mSimData0[] = {0x3c};
@@ -39,6 +41,11 @@ void ADBSimulationDataGenerator::Initialize(U32 simulation_sample_rate, ADBAnaly
 
 	/* Delay before first output */
 	mADBSimData.Advance(UsToSamples(100));
+
+	/* Faults to inject (settings have been validated), same pseudo random sequence every time */
+	std::string fault_error;
+	ParseFaults(mSettings->mSimulationFaults.c_str(), mFaultRates, &fault_error);
+	mRandomState = 0x9e3779b97f4a7c15ULL;
 }
 
 U32 ADBSimulationDataGenerator::GenerateSimulationData(U64 newest_sample_requested, U32 sample_rate,
@@ -48,80 +55,124 @@ U32 ADBSimulationDataGenerator::GenerateSimulationData(U64 newest_sample_request
 
 	while (mADBSimData.GetCurrentSampleNumber() < adjusted_largest_sample_requested)
 	{
-		/* Attention byte and sync flag */
-		SimWriteCycle(800, 65);
+		SimWriteTransaction();
+	}
 
-		/* Data */
-		for (U32 i = 0; i < mSimDataInfo[mSimIndex].len; i++)
-		{
-			if (1 == i)
-			{
-				/* First data byte, add stop to start time and start bit */
-				mADBSimData.Advance(UsToSamples(200));
-				SimWriteCycle(35, 65);
-			}
+	*simulation_channels = &mADBSimData;
 
-			/* Output byte */
-			SimWriteByte(mSimDataInfo[mSimIndex].data[i]);
+	return 1;
+}
 
-			if (0 == i)
-			{
-				/* Output stop after command */
-				if (mSimDataInfo[mSimIndex].serviceReq)
-				{
-					/* Include service request */
-					SimWriteCycle(300, 0);
-				}
-				else
-				{
-					/* Regular stop */
-					SimWriteCycle(70, 0);
-				}
-			}
-		}
+void ADBSimulationDataGenerator::SimWriteTransaction()
+{
+	const SimDataInfo& info = mSimDataInfo[mSimIndex];
+	U32 uiBits = 8 * info.len;
+
+	/* Decide faults, every one is drawn for every transaction so each rate only affects its own fault */
+	bool abFaults[SimNumFaults];
+	for (U32 i = 0; i < SimNumFaults; i++) abFaults[i] = SimFaultOccurs(SimFault(i));
+
+	mSimBit = 0;
+	mSimTruncated = false;
+	mGlitchBit = abFaults[SimFaultGlitch] ? (SimRandom() % uiBits) : UINT32_MAX;
+	mStretchBit = abFaults[SimFaultBitCell] ? (SimRandom() % uiBits) : UINT32_MAX;
+	mTruncateBit = abFaults[SimFaultTruncate] ? (uiBits - 1 - (SimRandom() % 7)) : UINT32_MAX;
+
+	if (abFaults[SimFaultReset])
+	{
+		/* Global reset, then recovery before attention */
+		SimWriteCycle(4000, 1000);
+	}
 
-		if (mSimDataInfo[mSimIndex].len > 1)
+	/* Attention byte and sync flag */
+	SimWriteCycle(800, 65);
+
+	/* Data */
+	for (U32 i = 0; i < info.len; i++)
+	{
+		if (1 == i)
 		{
-			/* Output stop after last data byte */
-			SimWriteCycle(70, 0);
+			/* First data byte, add stop to start time and start bit */
+			mADBSimData.Advance(UsToSamples(200));
+			SimWriteCycle(35, 65);
 		}
 
-		/* Delay before next output */
-		mADBSimData.Advance(UsToSamples(11 * 1000)); /* 11ms */
+		/* Output byte */
+		SimWriteByte(info.data[i]);
 
-		/* Select next sequence */
-		mSimIndex++;
-		if (mSimIndex >= (sizeof(mSimDataInfo) / sizeof(mSimDataInfo[0])))
+		if ((0 == i) && !(abFaults[SimFaultStop] && (1 == info.len)))
 		{
-			mSimIndex = 0;
+			/* Output stop after command */
+			if (info.serviceReq || abFaults[SimFaultServiceRequest])
+			{
+				/* Include service request */
+				SimWriteCycle(300, 0);
+			}
+			else
+			{
+				/* Regular stop */
+				SimWriteCycle(70, 0);
+			}
 		}
 	}
 
-	*simulation_channels = &mADBSimData;
+	if ((info.len > 1) && !abFaults[SimFaultStop])
+	{
+		/* Output stop after last data byte */
+		SimWriteCycle(70, 0);
+	}
 
-	return 1;
+	/* Delay before next output */
+	mADBSimData.Advance(UsToSamples(11 * 1000)); /* 11ms */
+
+	/* Select next sequence */
+	mSimIndex++;
+	if (mSimIndex >= (sizeof(mSimDataInfo) / sizeof(mSimDataInfo[0])))
+	{
+		mSimIndex = 0;
+	}
 }
 
 void ADBSimulationDataGenerator::SimWriteByte(U8 value)
 {
-	for (U32 i = 0; i < 8; ++i)
+	for (U32 i = 0; i < 8; ++i, ++mSimBit)
 	{
+		/* Truncated transaction outputs nothing more */
+		if (mSimBit == mTruncateBit) mSimTruncated = true;
+
 		U8 bit = (0 != ((value << i) & 0x80));
-		if (bit)
+		U32 lowPeriod = bit ? 35 : 65;
+		U32 highPeriod = bit ? 65 : 35;
+
+		if (mSimBit == mStretchBit)
 		{
-			/* Output one */
-			SimWriteCycle(35, 65);
+			/* Out of tolerance bit cell */
+			lowPeriod = (lowPeriod * 3) / 2;
+			highPeriod = (highPeriod * 3) / 2;
+		}
+
+		if (mSimBit == mGlitchBit)
+		{
+			/* Brief low pulse half way through high part of cell */
+			SimWriteCycle(lowPeriod, highPeriod / 2);
+			SimWriteCycle(1, highPeriod - (highPeriod / 2) - 1);
 		}
 		else
 		{
-			/* Output zero */
-			SimWriteCycle(65, 35);
+			SimWriteCycle(lowPeriod, highPeriod);
 		}
 	}
 }
 
 void ADBSimulationDataGenerator::SimWriteCycle(U32 lowPeriod, U32 highPeriod)
 {
+	if (mSimTruncated)
+	{
+		/* Bus left idle instead */
+		mADBSimData.Advance(UsToSamples(lowPeriod + highPeriod));
+		return;
+	}
+
 	mADBSimData.Transition();
 	mADBSimData.Advance(UsToSamples(lowPeriod));
 	mADBSimData.Transition();
@@ -132,3 +183,63 @@ U64 ADBSimulationDataGenerator::UsToSamples(double us)
 {
 	return U64((mSimulationSampleRateHz * us) / 1000000.0);
 }
+
+bool ADBSimulationDataGenerator::SimFaultOccurs(SimFault eFault)
+{
+	return (SimRandom() % 1000000) < mFaultRates[eFault];
+}
+
+U32 ADBSimulationDataGenerator::SimRandom()
+{
+	/* xorshift64* */
+	mRandomState ^= mRandomState >> 12;
+	mRandomState ^= mRandomState << 25;
+	mRandomState ^= mRandomState >> 27;
+	return U32((mRandomState * 0x2545f4914f6cdd1dULL) >> 32);
+}
+
+bool ADBSimulationDataGenerator::ParseFaults(const char* pszFaults, U32 *pauiRates, std::string* pError)
+{
+	static const char* const apszNames[SimNumFaults] = {"glitch", "truncate", "cell", "stop", "reset", "srq"};
+
+	for (U32 i = 0; i < SimNumFaults; i++) pauiRates[i] = 0;
+
+	/* Split into 'name=percent' fields */
+	std::string faults(pszFaults);
+	for (size_t i = 0; i < faults.size(); i++)
+	{
+		if (',' == faults[i]) faults[i] = ' ';
+	}
+
+	std::stringstream ss(faults);
+	std::string field;
+	while (ss >> field)
+	{
+		size_t equals = field.find('=');
+		std::string name = field.substr(0, equals);
+
+		U32 uiFault;
+		for (uiFault = 0; uiFault < SimNumFaults; uiFault++)
+		{
+			if (name == apszNames[uiFault]) break;
+		}
+		if (SimNumFaults == uiFault)
+		{
+			*pError = "Simulation faults: unknown fault '" + name + "', expected glitch, truncate, cell, stop, reset or srq";
+			return false;
+		}
+
+		char* end = NULL;
+		const char* pszRate = (std::string::npos == equals) ? "" : (field.c_str() + equals + 1);
+		double dRate = strtod(pszRate, &end);
+		if (('\0' == *pszRate) || ('\0' != *end) || (dRate < 0.0) || (dRate > 100.0))
+		{
+			*pError = "Simulation faults: rate of " + name + " must be a percentage from 0 to 100";
+			return false;
+		}
+
+		pauiRates[uiFault] = U32((dRate * 10000.0) + 0.5);
+	}
+
+	return true;
+}
@@ -1,10 +1,38 @@
 #ifndef ADB_SIMULATION_DATA_GENERATOR
 #define ADB_SIMULATION_DATA_GENERATOR
 
+#pragma warning(push, 0)
+#include <string>
+#pragma warning(pop)
+
 #include <AnalyzerHelpers.h>
 
 class ADBAnalyzerSettings;
 
+/* Faults which may be injected into simulated transactions */
+enum SimFault
+{
+	/* 1 us low pulse within a bit cell */
+	SimFaultGlitch,
+
+	/* Transaction ends part way through its last byte */
+	SimFaultTruncate,
+
+	/* Bit cell 50% longer than nominal */
+	SimFaultBitCell,
+
+	/* Final stop bit missing */
+	SimFaultStop,
+
+	/* Global reset ahead of transaction */
+	SimFaultReset,
+
+	/* Service request added to command stop bit */
+	SimFaultServiceRequest,
+
+	SimNumFaults
+};
+
 struct SimDataInfo
 {
 	const U8 *data;
@@ -21,13 +49,25 @@ class ADBSimulationDataGenerator
 		void Initialize(U32 simulation_sample_rate, ADBAnalyzerSettings* settings);
 		U32 GenerateSimulationData(U64 newest_sample_requested, U32 sample_rate, SimulationChannelDescriptor** simulation_channels);
 
+		/* Parse fault rates ('name=percent' separated by spaces or commas) to parts per million, returns false with description on error */
+		static bool ParseFaults(const char* pszFaults, U32 *pauiRates, std::string* pError);
+
 	protected:
+		/* Write next transaction to the output */
+		void SimWriteTransaction();
+
 		/* Write a byte to the output */
 		void SimWriteByte(U8 value);
 
 		/* Output a cycle of the waveform */
 		void SimWriteCycle(U32 lowPeriod, U32 highPeriod);
 
+		/* Check whether fault occurs */
+		bool SimFaultOccurs(SimFault eFault);
+
+		/* Next pseudo random number, sequence is the same for every simulation */
+		U32 SimRandom();
+
 		/* Convert microseconds to sample count */
 		U64 UsToSamples(double us);
 
@@ -46,6 +86,17 @@ class ADBSimulationDataGenerator
 		/* Current simulation data index */
 		U8 mSimIndex;
 
+		/* Fault rates (parts per million of transactions) and random number state */
+		U32 mFaultRates[SimNumFaults];
+		U64 mRandomState;
+
+		/* Faults of transaction being written, bits are counted from the start of the command byte */
+		U32 mSimBit;
+		U32 mGlitchBit;
+		U32 mStretchBit;
+		U32 mTruncateBit;
+		bool mSimTruncated;
+
 		/* Channel description */
 		SimulationChannelDescriptor mADBSimData;
 };
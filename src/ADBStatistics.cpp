@@ -0,0 +1,84 @@
+#pragma warning(push, 0)
+#include <cstring>
+#pragma warning(pop)
+
+#include "ADBStatistics.h"
+#include "ADBAnalyzer.h"
+
+ADBStatistics::ADBStatistics()
+	: mServiceRequestRun(0)
+{
+	memset(&mData, 0, sizeof(mData));
+}
+
+ADBStatistics::~ADBStatistics()
+{
+}
+
+bool ADBStatistics::AddTransaction(U8 byCommand, U8 uiDataLen, bool bServiceRequested, U64 uiStart, U64 uiEnd)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	mData.auiCommandCounts[byCommand]++;
+	mData.uiTransactions++;
+	mData.uiDataBytes += uiDataLen;
+
+	/* Device addressed */
+	U8 uiAddr = ((byCommand >> ADBAnalyzer::mADBCommandAddrShift) & ADBAnalyzer::mADBCommandAddrMask);
+	ADBCommand eCode = ADBCommand((byCommand >> ADBAnalyzer::mADBCommandCodeShift) & ADBAnalyzer::mADBCommandCodeMask);
+	ADBDeviceStatistics& device = mData.aDevices[uiAddr];
+
+	if ((Talk == eCode) && (uiDataLen > 0)) device.uiTalkResponses++;
+	device.uiDataBytes += uiDataLen;
+	if (0 == device.uiLastActivity) device.uiFirstActivity = uiStart; /* No transaction ends at sample zero */
+	device.uiLastActivity = uiEnd;
+
+	/* Service request counted against the device whose talk serviced it */
+	U8 uiServicedAddr;
+	U64 uiRequestStart;
+	U64 uiServiceStart;
+	if (mServiceRequestTracker.AddTransaction(byCommand, uiDataLen, bServiceRequested, uiStart, uiEnd, &uiServicedAddr, &uiRequestStart, &uiServiceStart))
+	{
+		mData.aDevices[uiServicedAddr].uiServiceRequests++;
+	}
+
+	if (!bServiceRequested)
+	{
+		/* Run over */
+		mServiceRequestRun = 0;
+		return false;
+	}
+
+	mData.uiServiceRequests++;
+
+	/* Storm counted once, when run reaches storm length */
+	mServiceRequestRun++;
+	if (mServiceRequestRun == mServiceRequestStormLength)
+	{
+		mData.uiServiceRequestStorms++;
+		return true;
+	}
+
+	return false;
+}
+
+void ADBStatistics::AddTimingViolation()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	mData.uiTimingViolations++;
+}
+
+void ADBStatistics::AddGlobalReset()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	mData.uiGlobalResets++;
+}
+
+void ADBStatistics::GetSnapshot(ADBStatisticsData* pData)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	*pData = mData;
+}
@@ -0,0 +1,93 @@
+#ifndef ADB_STATISTICS
+#define ADB_STATISTICS
+
+#pragma warning(push, 0)
+#include <mutex>
+#pragma warning(pop)
+
+#include <LogicPublicTypes.h>
+#include "ADBBusAnalytics.h"
+
+/* Activity of a single device (command mix is given by the command counts) */
+struct ADBDeviceStatistics
+{
+	/* Talk commands answered with data (others timed out) */
+	U64 uiTalkResponses;
+
+	/* Data bytes transferred in either direction */
+	U64 uiDataBytes;
+
+	/* Service requests serviced by a talk to the device (see ADBServiceRequestTracker) */
+	U64 uiServiceRequests;
+
+	/* Attention pulse of first transaction and end of last, valid if any commands were counted */
+	U64 uiFirstActivity;
+	U64 uiLastActivity;
+};
+
+/* Snapshot of bus statistics */
+struct ADBStatisticsData
+{
+	/* Completed transactions, per command byte (address / command / register) */
+	U64 auiCommandCounts[256];
+	U64 uiTransactions;
+
+	/* Data bytes transferred */
+	U64 uiDataBytes;
+
+	/* Transactions carrying a service request */
+	U64 uiServiceRequests;
+
+	/* Transactions abandoned part way through due to timing */
+	U64 uiTimingViolations;
+
+	/* Global resets */
+	U64 uiGlobalResets;
+
+	/* Runs of consecutive transactions carrying a service request */
+	U64 uiServiceRequestStorms;
+
+	/* Per address activity */
+	ADBDeviceStatistics aDevices[ADB_NUM_ADDRESSES];
+};
+
+/*
+** Rolling aggregates of bus activity, held in constant memory. Updated by the
+** worker thread and read when exporting.
+*/
+class ADBStatistics
+{
+	public:
+		ADBStatistics();
+		~ADBStatistics();
+
+		/* Consecutive transactions carrying a service request which constitute a storm */
+		static const U32 mServiceRequestStormLength = 8;
+
+		/* Count completed transaction, from attention pulse start to end of final stop bit, returns true if it makes a run of service requests a storm */
+		bool AddTransaction(U8 byCommand, U8 uiDataLen, bool bServiceRequested, U64 uiStart, U64 uiEnd);
+
+		/* Count transaction abandoned due to timing */
+		void AddTimingViolation();
+
+		/* Count global reset */
+		void AddGlobalReset();
+
+		/* Copy current values */
+		void GetSnapshot(ADBStatisticsData* pData);
+
+	protected:
+		/* Current values */
+		ADBStatisticsData mData;
+
+		/* Length of current run of transactions carrying a service request */
+		U32 mServiceRequestRun;
+
+		/* Service requests until serviced, to count them against the device serviced */
+		ADBServiceRequestTracker mServiceRequestTracker;
+
+		/* Export may read while the worker thread updates */
+		std::mutex mMutex;
+};
+
+#endif // ADB_STATISTICS
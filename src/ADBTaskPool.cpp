@@ -0,0 +1,78 @@
+#include "ADBTaskPool.h"
+
+ADBTaskPool::ADBTaskPool()
+	: mTask(NULL), mParts(0), mNextPart(0), mPartsDone(0), mStopRequested(false)
+{
+}
+
+ADBTaskPool::~ADBTaskPool()
+{
+	Stop();
+}
+
+void ADBTaskPool::Start(U32 uiThreads)
+{
+	if (!mThreads.empty()) return;
+
+	mStopRequested = false;
+	for (U32 i = 0; i < uiThreads; i++)
+	{
+		mThreads.push_back(std::thread(&ADBTaskPool::WorkerThread, this));
+	}
+}
+
+void ADBTaskPool::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopRequested = true;
+	}
+	mTaskCondition.notify_all();
+
+	for (size_t i = 0; i < mThreads.size(); i++) mThreads[i].join();
+	mThreads.clear();
+}
+
+void ADBTaskPool::Run(U32 uiParts, const std::function<void(U32)>& task)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mTask = &task;
+	mParts = uiParts;
+	mNextPart = 0;
+	mPartsDone = 0;
+	mTaskCondition.notify_all();
+
+	/* Take a share, then wait for parts other threads took */
+	RunParts(lock);
+	mDoneCondition.wait(lock, [this] { return mPartsDone == mParts; });
+	mTask = NULL;
+}
+
+void ADBTaskPool::RunParts(std::unique_lock<std::mutex>& lock)
+{
+	while (mNextPart < mParts)
+	{
+		/* Task stays in place until every part has finished */
+		const std::function<void(U32)>& task = *mTask;
+		U32 uiPart = mNextPart++;
+		lock.unlock();
+
+		task(uiPart);
+
+		lock.lock();
+		if (++mPartsDone == mParts) mDoneCondition.notify_all();
+	}
+}
+
+void ADBTaskPool::WorkerThread()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	for (;;)
+	{
+		mTaskCondition.wait(lock, [this] { return mStopRequested || ((NULL != mTask) && (mNextPart < mParts)); });
+		if (mStopRequested) return;
+
+		RunParts(lock);
+	}
+}
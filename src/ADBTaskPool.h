@@ -0,0 +1,55 @@
+#ifndef ADB_TASK_POOL
+#define ADB_TASK_POOL
+
+#pragma warning(push, 0)
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#pragma warning(pop)
+
+#include <LogicPublicTypes.h>
+
+/*
+** Fixed set of threads running the parts of a task in parallel, the calling
+** thread taking its share. Threads are started once and wait between tasks, so
+** a task costs a wake up per thread rather than creating any.
+*/
+class ADBTaskPool
+{
+	public:
+		ADBTaskPool();
+		~ADBTaskPool();
+
+		/* Start threads in addition to the calling one, unless already started */
+		void Start(U32 uiThreads);
+
+		/* Stop threads */
+		void Stop();
+
+		/* Run task for each part from zero to count - 1, returning once every part has finished */
+		void Run(U32 uiParts, const std::function<void(U32)>& task);
+
+	protected:
+		/* Run parts of current task until none are left (mutex locked on entry and exit) */
+		void RunParts(std::unique_lock<std::mutex>& lock);
+
+		/* Run parts of each task until stopped */
+		void WorkerThread();
+
+		/* Current task, number of its parts, next part to run and parts finished */
+		const std::function<void(U32)>* mTask;
+		U32 mParts;
+		U32 mNextPart;
+		U32 mPartsDone;
+
+		/* Threads, guarding of task */
+		std::vector<std::thread> mThreads;
+		std::mutex mMutex;
+		std::condition_variable mTaskCondition;
+		std::condition_variable mDoneCondition;
+		bool mStopRequested;
+};
+
+#endif // ADB_TASK_POOL
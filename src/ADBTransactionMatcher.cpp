@@ -0,0 +1,207 @@
+#pragma warning(push, 0)
+#include <cstring>
+#include <cstdlib>
+#include <sstream>
+#pragma warning(pop)
+
+#include "ADBTransactionMatcher.h"
+#include "ADBAnalyzer.h"
+
+ADBTransactionMatcher::ADBTransactionMatcher()
+{
+	memset(mTable, 0, sizeof(mTable));
+}
+
+ADBTransactionMatcher::~ADBTransactionMatcher()
+{
+}
+
+bool ADBTransactionMatcher::Compile(const char* pszPatterns, std::string* pError)
+{
+	mPatterns.clear();
+	memset(mTable, 0, sizeof(mTable));
+
+	/* Patterns are separated by ';', empty ones are ignored */
+	std::stringstream ss(pszPatterns);
+	std::string pattern;
+	while (std::getline(ss, pattern, ';'))
+	{
+		if (std::string::npos == pattern.find_first_not_of(" \t\r\n")) continue;
+
+		if (mPatterns.size() >= mMaxPatterns)
+		{
+			*pError = "Too many match patterns";
+			mPatterns.clear();
+			memset(mTable, 0, sizeof(mTable));
+			return false;
+		}
+
+		if (!CompilePattern(pattern, pError))
+		{
+			mPatterns.clear();
+			memset(mTable, 0, sizeof(mTable));
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool ADBTransactionMatcher::CompilePattern(const std::string& pattern, std::string* pError)
+{
+	U32 uiIndex = U32(mPatterns.size());
+
+	std::stringstream prefix;
+	prefix << "Match pattern " << (uiIndex + 1) << ": ";
+
+	/* Split into fields */
+	std::vector<std::string> fields;
+	std::stringstream ss(pattern);
+	std::string field;
+	while (ss >> field) fields.push_back(field);
+
+	if (fields.size() < 3)
+	{
+		*pError = prefix.str() + "expected address, command and register";
+		return false;
+	}
+
+	/* Command byte fields */
+	bool bAnyAddr;
+	U32 uiAddr;
+	if (!ParseField(fields[0], 0, ADBAnalyzer::mADBCommandAddrMask, &bAnyAddr, &uiAddr))
+	{
+		*pError = prefix.str() + "invalid address '" + fields[0] + "'";
+		return false;
+	}
+
+	bool bAnyReg;
+	U32 uiReg;
+	if (!ParseField(fields[2], 0, ADBAnalyzer::mADBCommandRegMask, &bAnyReg, &uiReg))
+	{
+		*pError = prefix.str() + "invalid register '" + fields[2] + "'";
+		return false;
+	}
+
+	const std::string& cmd = fields[1];
+	bool bAnyCmd = ("*" == cmd);
+	if (	!bAnyCmd
+		 && ("talk" != cmd) && ("listen" != cmd) && ("send_reset" != cmd) && ("flush" != cmd) && ("reserved" != cmd)
+	   )
+	{
+		*pError = prefix.str() + "unknown command '" + cmd + "'";
+		return false;
+	}
+
+	/* Data bytes and service request condition */
+	Pattern entry;
+	entry.uiDataLen = 0;
+	entry.eServiceRequest = ServiceRequestAny;
+	for (size_t i = 3; i < fields.size(); i++)
+	{
+		if ("srq" == fields[i])
+		{
+			entry.eServiceRequest = ServiceRequestSet;
+			continue;
+		}
+		if ("!srq" == fields[i])
+		{
+			entry.eServiceRequest = ServiceRequestClear;
+			continue;
+		}
+
+		if (entry.uiDataLen >= 8)
+		{
+			*pError = prefix.str() + "more than 8 data bytes";
+			return false;
+		}
+
+		/* Value, optionally followed by mask */
+		std::string value = fields[i];
+		std::string mask;
+		size_t slash = value.find('/');
+		if (std::string::npos != slash)
+		{
+			mask = value.substr(slash + 1);
+			value = value.substr(0, slash);
+		}
+
+		bool bAnyValue;
+		U32 uiValue;
+		bool bAnyMask = false;
+		U32 uiMask = 0xff;
+		if (	!ParseField(value, 16, 0xff, &bAnyValue, &uiValue)
+			 || (!mask.empty() && (!ParseField(mask, 16, 0xff, &bAnyMask, &uiMask) || bAnyMask || bAnyValue))
+		   )
+		{
+			*pError = prefix.str() + "invalid data byte '" + fields[i] + "'";
+			return false;
+		}
+
+		if (bAnyValue) uiMask = 0x00;
+		entry.abyMask[entry.uiDataLen] = U8(uiMask);
+		entry.abyValue[entry.uiDataLen] = U8(uiValue & uiMask);
+		entry.uiDataLen++;
+	}
+
+	mPatterns.push_back(entry);
+
+	/* Mark every command byte satisfying the pattern */
+	for (U32 byCommand = 0; byCommand < 256; byCommand++)
+	{
+		U8 uiCmdAddr = ((byCommand >> ADBAnalyzer::mADBCommandAddrShift) & ADBAnalyzer::mADBCommandAddrMask);
+		ADBCommand eCode = ADBCommand((byCommand >> ADBAnalyzer::mADBCommandCodeShift) & ADBAnalyzer::mADBCommandCodeMask);
+		U8 uiCmdReg = ((byCommand >> ADBAnalyzer::mADBCommandRegShift) & ADBAnalyzer::mADBCommandRegMask);
+
+		if (	(bAnyAddr || (uiAddr == uiCmdAddr))
+			 && (bAnyReg || (uiReg == uiCmdReg))
+			 && (bAnyCmd || (cmd == ADBAnalyzer::CmdCodeRegToString(eCode, uiCmdReg)))
+		   )
+		{
+			mTable[byCommand] |= (1u << uiIndex);
+		}
+	}
+
+	return true;
+}
+
+bool ADBTransactionMatcher::ParseField(const std::string& field, int iBase, U32 uiMax, bool *pbAny, U32 *puiValue)
+{
+	*pbAny = ("*" == field);
+	*puiValue = 0;
+	if (*pbAny) return true;
+
+	if (field.empty()) return false;
+
+	char* end;
+	unsigned long ulValue = strtoul(field.c_str(), &end, iBase);
+	if (('\0' != *end) || (ulValue > uiMax)) return false;
+
+	*puiValue = U32(ulValue);
+	return true;
+}
+
+int ADBTransactionMatcher::Match(U8 byCommand, const U8 *pabyData, U8 uiDataLen, bool bServiceRequested) const
+{
+	/* Check candidate patterns for command, in order given */
+	U32 uiCandidates = mTable[byCommand];
+	for (U32 i = 0; 0 != uiCandidates; i++, uiCandidates >>= 1)
+	{
+		if (!(uiCandidates & 1)) continue;
+
+		const Pattern& pattern = mPatterns[i];
+
+		if ((ServiceRequestSet == pattern.eServiceRequest) && !bServiceRequested) continue;
+		if ((ServiceRequestClear == pattern.eServiceRequest) && bServiceRequested) continue;
+		if (uiDataLen < pattern.uiDataLen) continue;
+
+		U8 j;
+		for (j = 0; j < pattern.uiDataLen; j++)
+		{
+			if ((pabyData[j] & pattern.abyMask[j]) != pattern.abyValue[j]) break;
+		}
+		if (j == pattern.uiDataLen) return int(i);
+	}
+
+	return -1;
+}
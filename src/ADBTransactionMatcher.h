@@ -0,0 +1,76 @@
+#ifndef ADB_TRANSACTION_MATCHER
+#define ADB_TRANSACTION_MATCHER
+
+#pragma warning(push, 0)
+#include <string>
+#include <vector>
+#pragma warning(pop)
+
+#include <LogicPublicTypes.h>
+
+/*
+** Matches completed transactions against a list of patterns. Patterns are
+** separated by ';', each being whitespace separated fields:
+**
+**   <addr> <cmd> <reg> [<data> ...] [srq | !srq]
+**
+** Address and register are numbers, command is talk, listen, send_reset, flush
+** or reserved, any of them may be '*'. Data bytes are hex, either a value, a
+** value and mask as 'value/mask' or '*' for any, a transaction must carry at
+** least as many data bytes as given. 'srq' requires a service request, '!srq'
+** its absence.
+**
+** Patterns are compiled into a table keyed on command byte, holding which
+** patterns the command satisfies, leaving just data and service request to be
+** checked for each transaction.
+*/
+class ADBTransactionMatcher
+{
+	public:
+		ADBTransactionMatcher();
+		~ADBTransactionMatcher();
+
+		/* Most patterns supported */
+		static const U32 mMaxPatterns = 32;
+
+		/* Replace patterns, returns false with description on error (leaving no patterns) */
+		bool Compile(const char* pszPatterns, std::string* pError);
+
+		/* Check if there are any patterns */
+		bool IsEmpty() const { return mPatterns.empty(); }
+
+		/* Index of first pattern matching transaction, or -1 if none */
+		int Match(U8 byCommand, const U8 *pabyData, U8 uiDataLen, bool bServiceRequested) const;
+
+	protected:
+		/* Service request condition */
+		enum ServiceRequestCondition
+		{
+			ServiceRequestAny,
+			ServiceRequestSet,
+			ServiceRequestClear
+		};
+
+		/* Data and service request part of pattern */
+		struct Pattern
+		{
+			U8 uiDataLen;
+			U8 abyValue[8];
+			U8 abyMask[8];
+			ServiceRequestCondition eServiceRequest;
+		};
+
+		/* Compile single pattern */
+		bool CompilePattern(const std::string& pattern, std::string* pError);
+
+		/* Parse number, or '*' as any (returns false if invalid or above max) */
+		static bool ParseField(const std::string& field, int iBase, U32 uiMax, bool *pbAny, U32 *puiValue);
+
+		/* Patterns, in order given */
+		std::vector<Pattern> mPatterns;
+
+		/* Patterns satisfied by each command byte, bit per pattern */
+		U32 mTable[256];
+};
+
+#endif // ADB_TRANSACTION_MATCHER
@@ -0,0 +1,427 @@
+#pragma warning(push, 0)
+#include <cstring>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#endif
+#pragma warning(pop)
+
+#include "ADBTransactionStream.h"
+
+/* Store little endian values into record */
+static void StoreU32(U8 *pabyDest, U32 uiValue)
+{
+	for (int i = 0; i < 4; i++) pabyDest[i] = U8(uiValue >> (8 * i));
+}
+
+static void StoreU64(U8 *pabyDest, U64 uiValue)
+{
+	for (int i = 0; i < 8; i++) pabyDest[i] = U8(uiValue >> (8 * i));
+}
+
+ADBTransactionStream::ADBTransactionStream()
+	: mSampleRate(0), mConsumerConnected(false),
+#ifdef _WIN32
+	  mPipe(INVALID_HANDLE_VALUE), mWakeEvent(NULL),
+#else
+	  mListenSocket(-1), mConsumerSocket(-1),
+#endif
+	  mHead(0), mTail(0), mGeneration(0), mSequence(0), mDrops(0), mSendOffset(0), mStopRequested(false), mPublisherWaiting(false)
+{
+#ifndef _WIN32
+	mWakePipe[0] = -1;
+	mWakePipe[1] = -1;
+#endif
+}
+
+ADBTransactionStream::~ADBTransactionStream()
+{
+	Stop();
+}
+
+bool ADBTransactionStream::Start(const char* pszPath, U32 uiSampleRate)
+{
+	mSampleRate = uiSampleRate;
+	mGeneration++;
+
+	/* Already publishing to path, just restart numbering for the new decode, records still queued keep their generation */
+	if (mThread.joinable() && (mPath == pszPath))
+	{
+		mSequence = 0;
+		mDrops = 0;
+		return true;
+	}
+
+	Stop();
+
+	mPath = pszPath;
+	mSequence = 0;
+	mDrops = 0;
+	mHead = 0;
+	mTail = 0;
+	mRing.assign(size_t(mRingRecords) * mRecordSize, 0);
+	mSendBuffer.reserve(size_t(mSendRecords) * mRecordSize);
+	mSendBuffer.clear();
+	mSendOffset = 0;
+
+	if (!OpenEndpoint())
+	{
+		mPath.clear();
+		return false;
+	}
+
+	mStopRequested = false;
+	mPublisherWaiting = false;
+	mThread = std::thread(&ADBTransactionStream::PublisherThread, this);
+
+	return true;
+}
+
+void ADBTransactionStream::Stop()
+{
+	if (!mThread.joinable()) return;
+
+	mStopRequested = true;
+	WakePublisher();
+	mThread.join();
+
+	DisconnectConsumer();
+	CloseEndpoint();
+	mPath.clear();
+}
+
+void ADBTransactionStream::Publish(U8 byCommand, const U8 *pabyData, U8 uiDataLen, bool bServiceRequested, U64 uiStart, U64 uiEnd)
+{
+	if (!mThread.joinable()) return;
+
+	U32 uiSequence = mSequence++;
+
+	/* Drop record if consumer hasn't kept up */
+	U32 uiHead = mHead.load(std::memory_order_relaxed);
+	if ((uiHead - mTail.load(std::memory_order_acquire)) >= mRingRecords)
+	{
+		mDrops.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	U8 *pabyRecord = &mRing[size_t(uiHead & (mRingRecords - 1)) * mRecordSize];
+	EncodeRecord(pabyRecord, mGeneration, uiSequence, mDrops.load(std::memory_order_relaxed), mSampleRate, byCommand, pabyData, uiDataLen, bServiceRequested, uiStart, uiEnd);
+
+	mHead.store(uiHead + 1);
+
+	/* Publisher thread sleeping, wake it (once) for the record */
+	if (mPublisherWaiting.load() && mPublisherWaiting.exchange(false)) WakePublisher();
+}
+
+void ADBTransactionStream::EncodeRecord(U8 *pabyRecord, U8 uiGeneration, U32 uiSequence, U32 uiDrops, U32 uiSampleRate, U8 byCommand, const U8 *pabyData, U8 uiDataLen, bool bServiceRequested, U64 uiStart, U64 uiEnd)
+{
+	if (uiDataLen > 8) uiDataLen = 8;
+
+	StoreU32(&pabyRecord[0], uiSequence);
+	StoreU32(&pabyRecord[4], uiDrops);
+	StoreU64(&pabyRecord[8], uiStart);
+	StoreU64(&pabyRecord[16], uiEnd);
+	StoreU32(&pabyRecord[24], uiSampleRate);
+	pabyRecord[28] = byCommand;
+	pabyRecord[29] = uiDataLen;
+	pabyRecord[30] = bServiceRequested ? 0x01 : 0x00;
+	pabyRecord[31] = uiGeneration;
+	memset(&pabyRecord[32], 0, 8);
+	if (uiDataLen > 0) memcpy(&pabyRecord[32], pabyData, uiDataLen);
+}
+
+void ADBTransactionStream::PublisherThread()
+{
+	while (!mStopRequested)
+	{
+		if (!mConsumerConnected && AcceptConsumer())
+		{
+			/* New consumer starts at a record boundary */
+			mSendBuffer.clear();
+			mSendOffset = 0;
+		}
+
+		/* Refill once everything taken has been sent */
+		if (mSendOffset >= mSendBuffer.size())
+		{
+			mSendBuffer.clear();
+			mSendOffset = 0;
+			TakeRecords();
+		}
+
+		/* Nobody to send to, discard */
+		if (!mConsumerConnected)
+		{
+			bool bIdle = mSendBuffer.empty();
+			mSendBuffer.clear();
+			if (bIdle) WaitForWork(false);
+			continue;
+		}
+
+		if (mSendBuffer.empty())
+		{
+			WaitForWork(false);
+			continue;
+		}
+
+		long iSent = SendToConsumer(&mSendBuffer[mSendOffset], mSendBuffer.size() - mSendOffset);
+		if (iSent < 0)
+		{
+			/* Consumer gone, anything part sent is lost */
+			DisconnectConsumer();
+			mSendBuffer.clear();
+			mSendOffset = 0;
+		}
+		else if (0 == iSent)
+		{
+			/* Consumer busy */
+			WaitForWork(true);
+		}
+		else
+		{
+			mSendOffset += size_t(iSent);
+		}
+	}
+}
+
+void ADBTransactionStream::WaitForWork(bool bSendBlocked)
+{
+	/*
+	** Say we're waiting before looking at the ring, so a record published after
+	** the look sees it and wakes us. Wakes are kept until waited for, so one
+	** arriving before the wait, or a stop request, isn't lost.
+	*/
+	mPublisherWaiting.store(true);
+	if (!mStopRequested && (bSendBlocked || (mHead.load() == mTail.load(std::memory_order_relaxed)))) WaitEndpoint(bSendBlocked);
+	mPublisherWaiting.store(false);
+}
+
+U32 ADBTransactionStream::TakeRecords()
+{
+	U32 uiTail = mTail.load(std::memory_order_relaxed);
+	U32 uiCount = mHead.load(std::memory_order_acquire) - uiTail;
+	if (uiCount > mSendRecords) uiCount = mSendRecords;
+
+	for (U32 i = 0; i < uiCount; i++)
+	{
+		const U8 *pabyRecord = &mRing[size_t((uiTail + i) & (mRingRecords - 1)) * mRecordSize];
+		mSendBuffer.insert(mSendBuffer.end(), pabyRecord, pabyRecord + mRecordSize);
+	}
+
+	mTail.store(uiTail + uiCount, std::memory_order_release);
+
+	return uiCount;
+}
+
+#ifdef _WIN32
+
+bool ADBTransactionStream::OpenEndpoint()
+{
+	HANDLE hPipe = CreateNamedPipeA(mPath.c_str(), PIPE_ACCESS_OUTBOUND, PIPE_TYPE_BYTE | PIPE_NOWAIT, 1,
+									mSendRecords * mRecordSize, 0, 0, NULL);
+	if (INVALID_HANDLE_VALUE == hPipe) return false;
+
+	/* Auto reset, so each wake is used once */
+	HANDLE hEvent = CreateEventA(NULL, FALSE, FALSE, NULL);
+	if (NULL == hEvent)
+	{
+		CloseHandle(hPipe);
+		return false;
+	}
+
+	mPipe = hPipe;
+	mWakeEvent = hEvent;
+	return true;
+}
+
+void ADBTransactionStream::CloseEndpoint()
+{
+	if (INVALID_HANDLE_VALUE == mPipe) return;
+
+	CloseHandle(mPipe);
+	mPipe = INVALID_HANDLE_VALUE;
+	CloseHandle(mWakeEvent);
+	mWakeEvent = NULL;
+}
+
+bool ADBTransactionStream::AcceptConsumer()
+{
+	/* Non blocking pipe reports whether a client has connected */
+	if (ConnectNamedPipe(mPipe, NULL) || (ERROR_PIPE_CONNECTED == GetLastError()))
+	{
+		mConsumerConnected = true;
+	}
+	else if (ERROR_NO_DATA == GetLastError())
+	{
+		/* Client connected and went again, ready pipe for the next */
+		DisconnectNamedPipe(mPipe);
+	}
+
+	return mConsumerConnected;
+}
+
+void ADBTransactionStream::DisconnectConsumer()
+{
+	if (!mConsumerConnected) return;
+
+	DisconnectNamedPipe(mPipe);
+	mConsumerConnected = false;
+}
+
+long ADBTransactionStream::SendToConsumer(const U8 *pabyData, size_t uiLen)
+{
+	DWORD uiWritten = 0;
+	if (!WriteFile(mPipe, pabyData, DWORD(uiLen), &uiWritten, NULL)) return -1;
+
+	return long(uiWritten);
+}
+
+void ADBTransactionStream::WaitEndpoint(bool bSendBlocked)
+{
+	/* Non blocking pipe can't be waited on, check it again after a while if that's what's awaited */
+	DWORD uiTimeoutMs = (!mConsumerConnected || bSendBlocked) ? mPipeCheckMs : INFINITE;
+	WaitForSingleObject(mWakeEvent, uiTimeoutMs);
+}
+
+void ADBTransactionStream::WakePublisher()
+{
+	if (NULL != mWakeEvent) SetEvent(mWakeEvent);
+}
+
+#else
+
+bool ADBTransactionStream::OpenEndpoint()
+{
+	sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (mPath.empty() || (mPath.size() >= sizeof(addr.sun_path))) return false;
+	memcpy(addr.sun_path, mPath.c_str(), mPath.size());
+
+	/* Remove socket left by an earlier run, but never anything else */
+	struct stat st;
+	if ((0 == stat(mPath.c_str(), &st)) && S_ISSOCK(st.st_mode)) unlink(mPath.c_str());
+
+	int iSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (iSocket < 0) return false;
+
+	if (	(0 != bind(iSocket, (sockaddr*)&addr, sizeof(addr)))
+		 || (0 != listen(iSocket, 1))
+		 || (0 != fcntl(iSocket, F_SETFL, fcntl(iSocket, F_GETFL) | O_NONBLOCK))
+	   )
+	{
+		close(iSocket);
+		return false;
+	}
+
+	/* Pipe to wake the publisher thread from poll, non blocking so neither waking nor draining it can block */
+	int aiWakePipe[2];
+	if (0 != pipe(aiWakePipe))
+	{
+		close(iSocket);
+		return false;
+	}
+	if (	(0 != fcntl(aiWakePipe[0], F_SETFL, fcntl(aiWakePipe[0], F_GETFL) | O_NONBLOCK))
+		 || (0 != fcntl(aiWakePipe[1], F_SETFL, fcntl(aiWakePipe[1], F_GETFL) | O_NONBLOCK))
+	   )
+	{
+		close(aiWakePipe[0]);
+		close(aiWakePipe[1]);
+		close(iSocket);
+		return false;
+	}
+
+	mListenSocket = iSocket;
+	mWakePipe[0] = aiWakePipe[0];
+	mWakePipe[1] = aiWakePipe[1];
+	return true;
+}
+
+void ADBTransactionStream::CloseEndpoint()
+{
+	if (mListenSocket < 0) return;
+
+	close(mListenSocket);
+	mListenSocket = -1;
+	unlink(mPath.c_str());
+
+	close(mWakePipe[0]);
+	close(mWakePipe[1]);
+	mWakePipe[0] = -1;
+	mWakePipe[1] = -1;
+}
+
+bool ADBTransactionStream::AcceptConsumer()
+{
+	int iSocket = accept(mListenSocket, NULL, NULL);
+	if (iSocket < 0) return false;
+
+	fcntl(iSocket, F_SETFL, fcntl(iSocket, F_GETFL) | O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+	int iSet = 1;
+	setsockopt(iSocket, SOL_SOCKET, SO_NOSIGPIPE, &iSet, sizeof(iSet));
+#endif
+
+	mConsumerSocket = iSocket;
+	mConsumerConnected = true;
+	return true;
+}
+
+void ADBTransactionStream::DisconnectConsumer()
+{
+	if (!mConsumerConnected) return;
+
+	close(mConsumerSocket);
+	mConsumerSocket = -1;
+	mConsumerConnected = false;
+}
+
+long ADBTransactionStream::SendToConsumer(const U8 *pabyData, size_t uiLen)
+{
+#ifdef MSG_NOSIGNAL
+	ssize_t iSent = send(mConsumerSocket, pabyData, uiLen, MSG_NOSIGNAL);
+#else
+	ssize_t iSent = send(mConsumerSocket, pabyData, uiLen, 0);
+#endif
+	if (iSent >= 0) return long(iSent);
+
+	/* Consumer not keeping up, rather than gone */
+	if ((EAGAIN == errno) || (EWOULDBLOCK == errno) || (EINTR == errno)) return 0;
+
+	return -1;
+}
+
+void ADBTransactionStream::WaitEndpoint(bool bSendBlocked)
+{
+	pollfd afd[2];
+	nfds_t uiNumFds = 0;
+	afd[uiNumFds++] = {mWakePipe[0], POLLIN, 0};
+	if (!mConsumerConnected) afd[uiNumFds++] = {mListenSocket, POLLIN, 0};
+	else if (bSendBlocked) afd[uiNumFds++] = {mConsumerSocket, POLLOUT, 0};
+
+	poll(afd, uiNumFds, -1);
+
+	/* Drain wakes, what they were for is checked by the caller */
+	U8 abyWakes[64];
+	while (read(mWakePipe[0], abyWakes, sizeof(abyWakes)) > 0) {}
+}
+
+void ADBTransactionStream::WakePublisher()
+{
+	if (mWakePipe[1] < 0) return;
+
+	/* Failing only when full, which already holds a wake */
+	U8 byWake = 0;
+	if (write(mWakePipe[1], &byWake, 1) < 0) return;
+}
+
+#endif
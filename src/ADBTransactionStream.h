@@ -0,0 +1,129 @@
+#ifndef ADB_TRANSACTION_STREAM
+#define ADB_TRANSACTION_STREAM
+
+#pragma warning(push, 0)
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#pragma warning(pop)
+
+#include <LogicPublicTypes.h>
+
+/*
+** Publishes completed transactions as fixed size binary records to a local
+** consumer, a Unix domain socket on Linux / macOS or a named pipe on Windows,
+** the analyzer being the listening end.
+**
+** The worker thread only copies records into a single producer / single
+** consumer ring, a publisher thread sending them on. Records which don't fit
+** because the consumer isn't keeping up are dropped and counted, so the worker
+** thread is never held up. Records published with no consumer connected are
+** discarded without being counted. With nothing to send the publisher thread
+** sleeps until a record is published, a consumer connects or one that wasn't
+** keeping up can take more (on Windows, where a non blocking named pipe can't
+** be waited on, it checks for those every mPipeCheckMs instead).
+**
+** Each decode of the capture has its own generation number, so a consumer
+** staying connected across decodes can tell records still queued from the
+** previous decode apart from those of the new one.
+**
+** Record layout (little endian, mRecordSize bytes):
+**
+**   0  U32  sequence number, from zero for each decode of the capture
+**   4  U32  records dropped so far in this decode
+**   8  U64  sample of attention pulse starting transaction
+**  16  U64  sample at start of final stop bit
+**  24  U32  sample rate
+**  28  U8   command byte
+**  29  U8   number of data bytes
+**  30  U8   flags, bit 0 set for service request
+**  31  U8   decode generation, incremented (wrapping) for each decode
+**  32  U8   data bytes [8], unused ones zero
+*/
+class ADBTransactionStream
+{
+	public:
+		ADBTransactionStream();
+		~ADBTransactionStream();
+
+		/* Size of each record */
+		static const U32 mRecordSize = 40;
+
+		/* Start publishing a new decode to path, a consumer already connected to the same path stays connected */
+		bool Start(const char* pszPath, U32 uiSampleRate);
+
+		/* Stop publishing, disconnecting any consumer */
+		void Stop();
+
+		/* Queue transaction (worker thread only, never blocks) */
+		void Publish(U8 byCommand, const U8 *pabyData, U8 uiDataLen, bool bServiceRequested, U64 uiStart, U64 uiEnd);
+
+		/* Fill record (mRecordSize bytes) for a transaction */
+		static void EncodeRecord(U8 *pabyRecord, U8 uiGeneration, U32 uiSequence, U32 uiDrops, U32 uiSampleRate, U8 byCommand, const U8 *pabyData, U8 uiDataLen, bool bServiceRequested, U64 uiStart, U64 uiEnd);
+
+		/* Records dropped in this decode */
+		U32 GetDropCount() const { return mDrops.load(std::memory_order_relaxed); }
+
+	protected:
+		/* Records held in ring (power of two), and most sent in one go */
+		static const U32 mRingRecords = 4096;
+		static const U32 mSendRecords = 64;
+
+		/* Publisher thread */
+		void PublisherThread();
+
+		/* Sleep until there's work, records to take or only the endpoint (consumer to accept or room to send) */
+		void WaitForWork(bool bSendBlocked);
+
+		/* Move records from ring to send buffer, returns number moved */
+		U32 TakeRecords();
+
+		/* Platform specific endpoint handling, send returns bytes sent or -1 once consumer has gone */
+		bool OpenEndpoint();
+		void CloseEndpoint();
+		bool AcceptConsumer();
+		void DisconnectConsumer();
+		long SendToConsumer(const U8 *pabyData, size_t uiLen);
+
+		/* Platform specific sleep until woken or endpoint ready, and wake from any thread (never blocks) */
+		void WaitEndpoint(bool bSendBlocked);
+		void WakePublisher();
+
+		/* Endpoint */
+		std::string mPath;
+		U32 mSampleRate;
+		bool mConsumerConnected;
+#ifdef _WIN32
+		void* mPipe;
+		void* mWakeEvent;
+
+		/* Interval at which a named pipe is checked for a consumer or room to send */
+		static const U32 mPipeCheckMs = 10;
+#else
+		int mListenSocket;
+		int mConsumerSocket;
+		int mWakePipe[2];
+#endif
+
+		/* Ring, written at head by worker thread and read at tail by publisher thread */
+		std::vector<U8> mRing;
+		std::atomic<U32> mHead;
+		std::atomic<U32> mTail;
+
+		/* Generation of this decode, sequence number of next record, and records dropped */
+		U8 mGeneration;
+		U32 mSequence;
+		std::atomic<U32> mDrops;
+
+		/* Records taken from ring not yet fully sent */
+		std::vector<U8> mSendBuffer;
+		size_t mSendOffset;
+
+		/* Publisher thread, request for it to finish, and whether it's waiting for a record */
+		std::thread mThread;
+		std::atomic<bool> mStopRequested;
+		std::atomic<bool> mPublisherWaiting;
+};
+
+#endif // ADB_TRANSACTION_STREAM
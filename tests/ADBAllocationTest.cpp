@@ -0,0 +1,181 @@
+/*
+** Counts heap allocations made while decoding a long synthetic capture. The
+** FrameV2 the SDK builds for each output frame allocates (its data lives
+** behind a pointer), so that is measured on its own and subtracted for every
+** frame output. What remains is the analyzer's own, which must allocate
+** nothing per transaction. Everything it keeps (packet index, register
+** timeline, decode log) grows amortised, so adds a bounded number overall.
+*/
+
+#pragma warning(push, 0)
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#pragma warning(pop)
+
+#include "ADBTestAnalyzer.h"
+#include "ADBTestSignal.h"
+
+/* Analyzer's own allocations allowed overall for setup and amortised growth */
+static const U64 mMaxOtherAllocations = 1024;
+
+static const U32 mSampleRate = 2000000;
+static const U64 mNumTransactions = 1000000;
+
+static std::atomic<bool> gbCounting(false);
+static std::atomic<U64> guiAllocations(0);
+
+static void* CountedAlloc(std::size_t uiSize)
+{
+	if (gbCounting) guiAllocations++;
+
+	void* p = malloc(uiSize ? uiSize : 1);
+	if (NULL == p) throw std::bad_alloc();
+	return p;
+}
+
+void* operator new(std::size_t uiSize) { return CountedAlloc(uiSize); }
+void* operator new[](std::size_t uiSize) { return CountedAlloc(uiSize); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+
+/*
+** Supplies the capture a block of transactions at a time, reusing the same
+** edge storage, so the source itself doesn't allocate while counting.
+*/
+class ADBRepeatingSource : public StubEdgeSource
+{
+	public:
+		ADBRepeatingSource(U64 uiNumTransactions)
+			: mSignal(mSampleRate), mNumTransactions(uiNumTransactions), mWritten(0)
+		{
+			/* Fill and drop a block up front, so capacity is reserved before counting */
+			WriteBlock();
+			mSignal.ClearEdges();
+			mWritten = 0;
+		}
+
+		virtual bool NextEdges(std::vector<U64>& edges)
+		{
+			if (mWritten >= mNumTransactions) return false;
+
+			mSignal.ClearEdges();
+			WriteBlock();
+			edges.insert(edges.end(), mSignal.GetEdges().begin(), mSignal.GetEdges().end());
+			return true;
+		}
+
+	protected:
+		void WriteBlock()
+		{
+			for (U32 i = 0; (i < mBlockTransactions) && (mWritten < mNumTransactions); i++, mWritten++)
+			{
+				/* Talk with changing data, listen, flush, then talk unanswered with a service request */
+				U8 abyData[2] = {0x82, U8(mWritten >> 2)};
+				switch (mWritten & 3)
+				{
+					case 0:
+						mSignal.Transaction(0x3C, abyData, 2, false, 1000);
+						break;
+					case 1:
+						abyData[0] = 0x62;
+						mSignal.Transaction(0x2B, abyData, 2, false, 1000);
+						break;
+					case 2:
+						mSignal.Transaction(0x31, NULL, 0, false, 1000);
+						break;
+					default:
+						mSignal.Transaction(0x2C, NULL, 0, true, 1000);
+						break;
+				}
+			}
+		}
+
+		static const U32 mBlockTransactions = 1024;
+
+		ADBTestSignal mSignal;
+		U64 mNumTransactions;
+		U64 mWritten;
+};
+
+/* Count allocations made building a FrameV2 filled as for a transaction */
+static U64 MeasureFrameV2Allocations()
+{
+	U8 abyData[8] = {0};
+	U8 uiByte = 0;
+
+	guiAllocations = 0;
+	gbCounting = true;
+	{
+		FrameV2 frame_v2;
+		frame_v2.AddByteArray("addr", &uiByte, sizeof(uiByte));
+		frame_v2.AddString("cmd", "Talk R0");
+		frame_v2.AddByteArray("reg", &uiByte, sizeof(uiByte));
+		frame_v2.AddByteArray("data", abyData, sizeof(abyData));
+		frame_v2.AddBoolean("svcreq", false);
+		frame_v2.AddInteger("match", 1);
+	}
+	gbCounting = false;
+
+	return guiAllocations;
+}
+
+/* Decode capture counting allocations, returning whether the analyzer's own are within bounds */
+static bool CheckAllocations(bool bStatisticsOnly, U64 uiFrameV2Allocations)
+{
+	ADBTestAnalyzer analyzer;
+	analyzer.SetRetainResults(false);
+	analyzer.GetSettings().mStatisticsOnly = bStatisticsOnly;
+
+	ADBRepeatingSource source(mNumTransactions);
+
+	guiAllocations = 0;
+	gbCounting = true;
+	analyzer.Decode(mSampleRate, BIT_HIGH, &source);
+	gbCounting = false;
+
+	/* The final transaction may still be awaiting the edge that ends it */
+	ADBStatisticsData statistics;
+	analyzer.GetResults().GetStatistics().GetSnapshot(&statistics);
+	U64 uiTransactions = statistics.uiTransactions;
+	U64 uiAllocations = guiAllocations;
+	U64 uiFrameAllocations = analyzer.GetResults().mNumFramesV2 * uiFrameV2Allocations;
+
+	printf("%s: %llu transactions, %llu allocations, %llu of them for %llu FrameV2s\n",
+		bStatisticsOnly ? "statistics only" : "full decode",
+		(unsigned long long)uiTransactions, (unsigned long long)uiAllocations,
+		(unsigned long long)uiFrameAllocations, (unsigned long long)analyzer.GetResults().mNumFramesV2);
+
+	bool bPass = true;
+	if ((uiTransactions + 1) < mNumTransactions)
+	{
+		printf("FAIL: only %llu of %llu transactions decoded\n", (unsigned long long)uiTransactions, (unsigned long long)mNumTransactions);
+		bPass = false;
+	}
+
+	if (uiAllocations < uiFrameAllocations)
+	{
+		printf("FAIL: fewer allocations than FrameV2s account for\n");
+		bPass = false;
+	}
+	else if ((uiAllocations - uiFrameAllocations) > mMaxOtherAllocations)
+	{
+		printf("FAIL: analyzer made %llu allocations of its own, at most %llu allowed\n",
+			(unsigned long long)(uiAllocations - uiFrameAllocations), (unsigned long long)mMaxOtherAllocations);
+		bPass = false;
+	}
+
+	return bPass;
+}
+
+int main()
+{
+	U64 uiFrameV2Allocations = MeasureFrameV2Allocations();
+	printf("FrameV2: %llu allocations each\n", (unsigned long long)uiFrameV2Allocations);
+
+	bool bPass = CheckAllocations(false, uiFrameV2Allocations);
+	bPass = CheckAllocations(true, uiFrameV2Allocations) && bPass;
+
+	return bPass ? 0 : 1;
+}
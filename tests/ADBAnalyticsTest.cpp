@@ -0,0 +1,114 @@
+/*
+** Bus analytics test, attributing service requests to the device which raised
+** them. Between a service request and the talk register 0 which services it,
+** the host may poll other registers, and other devices may answer talk
+** register 0 with data of their own. Neither may be taken as servicing the
+** request while a command to another address still shows it held. Analytics
+** and the per device statistics must agree.
+*/
+
+#pragma warning(push, 0)
+#include <cstdint>
+#include <cstdio>
+#pragma warning(pop)
+
+#include "ADBTestAnalyzer.h"
+#include "ADBTestSignal.h"
+
+static const U32 mSampleRate = 2000000;
+
+/* Idle after each transaction */
+static const double mIdleUs = 5000.0;
+
+/* Device raising service requests, and others on the bus */
+static const U8 mRequestingAddr = 2;
+static const U8 mPolledAddr = 3;
+static const U8 mOtherAddr = 5;
+
+static U8 TalkCommand(U8 uiAddr, U8 uiReg) { return U8((uiAddr << 4) | 0x0C | uiReg); }
+
+/* Check value, reporting any mismatch */
+static bool Expect(const char* pszWhat, U64 uiActual, U64 uiExpected)
+{
+	if (uiActual == uiExpected) return true;
+
+	printf("FAIL: %s is %llu, expected %llu\n", pszWhat, (unsigned long long)uiActual, (unsigned long long)uiExpected);
+	return false;
+}
+
+int main()
+{
+	ADBTestSignal signal(mSampleRate);
+	signal.Idle(mIdleUs);
+
+	const U8 abyData[2] = {0x12, 0x34};
+
+	/* Samples at start and end (after idle) of the transaction raising each request, and start of the talk servicing it */
+	U64 auiRequestStart[2];
+	U64 auiRequestEnd[2];
+	U64 auiServiceStart[2];
+
+	/* Service request seen on an unanswered poll, then register 3 polled while it's still held */
+	auiRequestStart[0] = signal.GetSample();
+	signal.Transaction(TalkCommand(mPolledAddr, 0), NULL, 0, true, mIdleUs);
+	auiRequestEnd[0] = signal.GetSample();
+	signal.Transaction(TalkCommand(mPolledAddr, 3), abyData, 2, true, mIdleUs);
+	signal.Transaction(TalkCommand(mOtherAddr, 3), abyData, 2, true, mIdleUs);
+	auiServiceStart[0] = signal.GetSample();
+	signal.Transaction(TalkCommand(mRequestingAddr, 0), abyData, 2, false, mIdleUs);
+	signal.Transaction(TalkCommand(mPolledAddr, 0), NULL, 0, false, mIdleUs);
+
+	/* Another device answers talk register 0 while the request is still held */
+	auiRequestStart[1] = signal.GetSample();
+	signal.Transaction(TalkCommand(mPolledAddr, 0), NULL, 0, true, mIdleUs);
+	auiRequestEnd[1] = signal.GetSample();
+	signal.Transaction(TalkCommand(mOtherAddr, 0), abyData, 2, true, mIdleUs);
+	auiServiceStart[1] = signal.GetSample();
+	signal.Transaction(TalkCommand(mRequestingAddr, 0), abyData, 2, false, mIdleUs);
+	signal.Transaction(TalkCommand(mPolledAddr, 0), NULL, 0, false, mIdleUs);
+
+	/* The last transaction only completes on the edge after it */
+	signal.Transaction(TalkCommand(mPolledAddr, 0), NULL, 0, false, mIdleUs);
+
+	ADBTestAnalyzer analyzer;
+	analyzer.Decode(mSampleRate, BIT_HIGH, signal.GetEdges());
+
+	ADBBusAnalyticsData analytics;
+	analyzer.GetResults().GetAnalytics().GetSnapshot(&analytics);
+
+	bool bPass = Expect("service requests", analytics.cServiceRequestLatency.GetCount(), 2);
+	bPass = Expect("service requests of requesting device", analytics.acServiceRequestLatency[mRequestingAddr].GetCount(), 2) && bPass;
+	bPass = Expect("service requests of polled device", analytics.acServiceRequestLatency[mPolledAddr].GetCount(), 0) && bPass;
+	bPass = Expect("service requests of other device", analytics.acServiceRequestLatency[mOtherAddr].GetCount(), 0) && bPass;
+
+	/* The statistics export counts the same requests against each device */
+	ADBStatisticsData statistics;
+	analyzer.GetResults().GetStatistics().GetSnapshot(&statistics);
+	bPass = Expect("statistics service requests of requesting device", statistics.aDevices[mRequestingAddr].uiServiceRequests, 2) && bPass;
+	bPass = Expect("statistics service requests of polled device", statistics.aDevices[mPolledAddr].uiServiceRequests, 0) && bPass;
+	bPass = Expect("statistics service requests of other device", statistics.aDevices[mOtherAddr].uiServiceRequests, 0) && bPass;
+
+	/* Latency runs from the end of the transaction raising the request to the start of the talk servicing it */
+	U64 uiMinLatencyUs = UINT64_MAX;
+	U64 uiMaxLatencyUs = 0;
+	for (U32 i = 0; i < 2; i++)
+	{
+		U64 uiShortestUs = ((auiServiceStart[i] - auiRequestEnd[i]) * 1000000) / mSampleRate;
+		U64 uiLongestUs = ((auiServiceStart[i] - auiRequestStart[i]) * 1000000) / mSampleRate;
+		if (uiShortestUs < uiMinLatencyUs) uiMinLatencyUs = uiShortestUs;
+		if (uiLongestUs > uiMaxLatencyUs) uiMaxLatencyUs = uiLongestUs;
+	}
+
+	printf("%llu service requests, latency %llu to %llu us, expected within %llu to %llu us\n",
+		(unsigned long long)analytics.cServiceRequestLatency.GetCount(),
+		(unsigned long long)analytics.cServiceRequestLatency.GetMin(), (unsigned long long)analytics.cServiceRequestLatency.GetMax(),
+		(unsigned long long)uiMinLatencyUs, (unsigned long long)uiMaxLatencyUs);
+
+	if ((analytics.cServiceRequestLatency.GetMin() < uiMinLatencyUs) || (analytics.cServiceRequestLatency.GetMax() > uiMaxLatencyUs))
+	{
+		printf("FAIL: service request latency out of range\n");
+		bPass = false;
+	}
+
+	return bPass ? 0 : 1;
+}
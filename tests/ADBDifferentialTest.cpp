@@ -0,0 +1,543 @@
+/*
+** Differential test, pinning the decoder's optimised paths to a plain decode of
+** the same capture. Each capture is decoded afresh for reference and compared,
+** frame by frame, marker by marker and transaction by transaction (sample
+** positions, data, types and flags), against:
+**
+**   - incremental replay, re-decoding with changed settings, reusing the
+**     decode log of the previous decode,
+**   - the glitch filter, decoding with glitches narrower than the filter added
+**     to a capture without them,
+**   - adaptive device timing, decoding a capture with nominal device timing.
+**
+** Captures are generated at random from families of traffic (nominal, jitter
+** at the tolerance limits, truncated transactions, glitches, back to back
+** transactions, resets and a mix of them all) and by the analyzer's own
+** simulation with fault injection. Captures kept in the corpus are replayed as
+** well, and any capture which fails is written out so it can be added to it.
+**
+** usage: adb_differential_test [-s <seeds>] [-w <corpus dir>] [corpus files...]
+*/
+
+#pragma warning(push, 0)
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#pragma warning(pop)
+
+#include "ADBTestAnalyzer.h"
+#include "ADBTestSignal.h"
+
+static const U32 mSampleRate = 2000000;
+
+/* Transactions in each generated capture, and seeds of each family by default */
+static const U32 mTransactionsPerCapture = 100;
+static const U32 mDefaultSeeds = 20;
+
+/* Length of simulated capture, and faults injected into it */
+static const U64 mSimulationSamples = 4 * mSampleRate;
+static const char mSimulationFaults[] = "glitch=5 truncate=5 cell=5 stop=5 reset=2 srq=5";
+
+/* Glitch filter width, in samples */
+static const U64 mGlitchFilterSamples = 4;
+
+/* Families of generated traffic */
+enum ADBFamily
+{
+	FamilyNominal,
+	FamilyJitter,
+	FamilyTruncated,
+	FamilyGlitches,
+	FamilyBackToBack,
+	FamilyResets,
+	FamilyMixed,
+	NumFamilies
+};
+
+static const char* const mFamilyNames[NumFamilies] = {"nominal", "jitter", "truncated", "glitches", "back_to_back", "resets", "mixed"};
+
+/* Capture decoded, with whether its device timing is nominal (adaptive timing then changes nothing) */
+struct ADBCapture
+{
+	std::string name;
+	U32 uiSampleRate;
+	BitState eInitial;
+	std::vector<U64> auiEdges;
+	bool bNominalDeviceTiming;
+};
+
+/* Settings changed between decodes of the same capture */
+struct ADBDecodeSettings
+{
+	U32 uiHostPct;
+	U32 uiDevicePct;
+	U32 uiLowTimePct;
+	U32 uiStopToStartMinUs;
+	U32 uiStopToStartMaxUs;
+	bool bGlitchFilter;
+};
+
+/* Settings decoded with in turn, a repeat replaying everything, changes only what their limits reach */
+static const ADBDecodeSettings mReplaySettings[] =
+{
+	{3, 30, 5, 140, 260, false},
+	{3, 30, 5, 140, 260, false},
+	{4, 25, 5, 140, 260, false},
+	{3, 35, 7, 140, 260, false},
+	{2, 20, 3, 140, 260, false},
+	{2, 20, 3, 150, 250, false},
+	{3, 30, 5, 140, 260, true},
+	{3, 30, 5, 140, 260, true},
+};
+
+/* Totals over the run */
+static U32 guiCaptures = 0;
+static U32 guiComparisons = 0;
+static U32 guiFailures = 0;
+
+/* Glitch filter setting giving at least the filter width in samples at sample rate */
+static U32 GlitchFilterNs(U32 uiSampleRate)
+{
+	return U32(((mGlitchFilterSamples * 1000000000ull) + uiSampleRate - 1) / uiSampleRate);
+}
+
+static void ApplySettings(ADBTestAnalyzer& analyzer, const ADBDecodeSettings& settings, U32 uiSampleRate)
+{
+	ADBAnalyzerSettings& analyzer_settings = analyzer.GetSettings();
+	analyzer_settings.mHostErrorPct = settings.uiHostPct;
+	analyzer_settings.mDeviceErrorPct = settings.uiDevicePct;
+	analyzer_settings.mLowTimeErrorPct = settings.uiLowTimePct;
+	analyzer_settings.mStopToStartMinUs = settings.uiStopToStartMinUs;
+	analyzer_settings.mStopToStartMaxUs = settings.uiStopToStartMaxUs;
+	analyzer_settings.mGlitchFilterNs = settings.bGlitchFilter ? GlitchFilterNs(uiSampleRate) : 0;
+}
+
+/* Describe first difference between results, empty if there's none */
+static std::string CompareResults(ADBAnalyzerResults& reference, ADBAnalyzerResults& other)
+{
+	std::ostringstream difference;
+
+	for (size_t i = 0; (i < reference.mFrames.size()) && (i < other.mFrames.size()); i++)
+	{
+		const Frame& a = reference.mFrames[i];
+		const Frame& b = other.mFrames[i];
+		if (   (a.mStartingSampleInclusive != b.mStartingSampleInclusive) || (a.mEndingSampleInclusive != b.mEndingSampleInclusive)
+			|| (a.mData1 != b.mData1) || (a.mData2 != b.mData2) || (a.mType != b.mType) || (a.mFlags != b.mFlags))
+		{
+			difference << "frame " << i << ": samples " << a.mStartingSampleInclusive << "-" << a.mEndingSampleInclusive
+					   << " type " << int(a.mType) << " flags " << int(a.mFlags) << " data " << a.mData1
+					   << ", against samples " << b.mStartingSampleInclusive << "-" << b.mEndingSampleInclusive
+					   << " type " << int(b.mType) << " flags " << int(b.mFlags) << " data " << b.mData1;
+			return difference.str();
+		}
+	}
+	if (reference.mFrames.size() != other.mFrames.size())
+	{
+		difference << reference.mFrames.size() << " frames, against " << other.mFrames.size();
+		return difference.str();
+	}
+
+	for (size_t i = 0; (i < reference.mMarkers.size()) && (i < other.mMarkers.size()); i++)
+	{
+		if (!(reference.mMarkers[i] == other.mMarkers[i]))
+		{
+			difference << "marker " << i << ": sample " << reference.mMarkers[i].uiSample << " type " << int(reference.mMarkers[i].eType)
+					   << ", against sample " << other.mMarkers[i].uiSample << " type " << int(other.mMarkers[i].eType);
+			return difference.str();
+		}
+	}
+	if (reference.mMarkers.size() != other.mMarkers.size())
+	{
+		difference << reference.mMarkers.size() << " markers, against " << other.mMarkers.size();
+		return difference.str();
+	}
+
+	for (size_t i = 0; (i < reference.mFramesV2.size()) && (i < other.mFramesV2.size()); i++)
+	{
+		if (reference.mFramesV2[i] != other.mFramesV2[i])
+		{
+			const StubFrameV2Record& a = reference.mFramesV2[i];
+			const StubFrameV2Record& b = other.mFramesV2[i];
+			difference << "transaction " << i << ": " << a.type << " samples " << a.uiStart << "-" << a.uiEnd;
+			for (size_t j = 0; j < a.fields.size(); j++) difference << " " << a.fields[j];
+			difference << ", against " << b.type << " samples " << b.uiStart << "-" << b.uiEnd;
+			for (size_t j = 0; j < b.fields.size(); j++) difference << " " << b.fields[j];
+			return difference.str();
+		}
+	}
+	if (reference.mFramesV2.size() != other.mFramesV2.size())
+	{
+		difference << reference.mFramesV2.size() << " transactions, against " << other.mFramesV2.size();
+		return difference.str();
+	}
+
+	if (reference.mPackets != other.mPackets)
+	{
+		difference << "packets differ";
+		return difference.str();
+	}
+
+	ADBStatisticsData reference_statistics;
+	ADBStatisticsData other_statistics;
+	reference.GetStatistics().GetSnapshot(&reference_statistics);
+	other.GetStatistics().GetSnapshot(&other_statistics);
+	if (0 != memcmp(&reference_statistics, &other_statistics, sizeof(reference_statistics)))
+	{
+		difference << "statistics differ";
+		return difference.str();
+	}
+
+	return difference.str();
+}
+
+/* Save capture in corpus format, returning false on error */
+static bool WriteCapture(const ADBCapture& capture, const std::string& path)
+{
+	FILE* f = fopen(path.c_str(), "w");
+	if (NULL == f) return false;
+
+	fprintf(f, "# ADB differential test capture: %s\n", capture.name.c_str());
+	fprintf(f, "rate %u\n", capture.uiSampleRate);
+	fprintf(f, "initial %s\n", (BIT_HIGH == capture.eInitial) ? "high" : "low");
+	fprintf(f, "device_timing %s\n", capture.bNominalDeviceTiming ? "nominal" : "varied");
+	for (size_t i = 0; i < capture.auiEdges.size(); i++) fprintf(f, "%llu\n", (unsigned long long)capture.auiEdges[i]);
+
+	return (0 == fclose(f));
+}
+
+/* Load capture in corpus format, returning false on error */
+static bool ReadCapture(const char* pszPath, ADBCapture* pCapture)
+{
+	FILE* f = fopen(pszPath, "r");
+	if (NULL == f) return false;
+
+	pCapture->name = pszPath;
+	pCapture->uiSampleRate = 0;
+	pCapture->eInitial = BIT_HIGH;
+	pCapture->auiEdges.clear();
+	pCapture->bNominalDeviceTiming = false;
+
+	/* Comments and settings, then an edge sample per line */
+	bool bOK = true;
+	char acLine[256];
+	char acValue[64];
+	unsigned long long uiValue;
+	while (bOK && (NULL != fgets(acLine, sizeof(acLine), f)))
+	{
+		if (('#' == acLine[0]) || ('\n' == acLine[0]))
+		{
+			continue;
+		}
+		else if (1 == sscanf(acLine, "rate %llu", &uiValue))
+		{
+			pCapture->uiSampleRate = U32(uiValue);
+		}
+		else if (1 == sscanf(acLine, "initial %63s", acValue))
+		{
+			pCapture->eInitial = (0 == strcmp(acValue, "low")) ? BIT_LOW : BIT_HIGH;
+		}
+		else if (1 == sscanf(acLine, "device_timing %63s", acValue))
+		{
+			pCapture->bNominalDeviceTiming = (0 == strcmp(acValue, "nominal"));
+		}
+		else if (1 == sscanf(acLine, "%llu", &uiValue))
+		{
+			bOK = pCapture->auiEdges.empty() || (uiValue > pCapture->auiEdges.back());
+			pCapture->auiEdges.push_back(uiValue);
+		}
+		else
+		{
+			bOK = false;
+		}
+	}
+
+	fclose(f);
+	return bOK && (0 != pCapture->uiSampleRate);
+}
+
+/* Output random transaction, cut short if wanted */
+static void RandomTransaction(ADBTestSignal& signal, std::mt19937& random, bool bTruncate, double dIdleUs)
+{
+	U8 byCommand = U8(random());
+	U8 abyData[8];
+	for (U32 i = 0; i < sizeof(abyData); i++) abyData[i] = U8(random());
+
+	/* Talk answered or not, listen always carries data, other commands never do */
+	U8 uiDataLen = 0;
+	switch ((byCommand >> 2) & 3)
+	{
+		case 3:
+			uiDataLen = (0 != (random() % 4)) ? U8(2 + (random() % 7)) : 0;
+			break;
+		case 2:
+			uiDataLen = U8(2 + (random() % 7));
+			break;
+		default:
+			break;
+	}
+
+	if (bTruncate)
+	{
+		signal.TruncatedTransaction(byCommand, abyData, uiDataLen, 1 + (random() % (8 + (8 * uiDataLen))), dIdleUs);
+	}
+	else
+	{
+		signal.Transaction(byCommand, abyData, uiDataLen, 0 == (random() % 8), dIdleUs);
+	}
+}
+
+/* Generate capture of traffic family from seed */
+static void GenerateCapture(ADBFamily eFamily, U32 uiSeed, ADBCapture* pCapture)
+{
+	std::mt19937 random((uiSeed * NumFamilies) + eFamily);
+	ADBTestSignal signal(mSampleRate);
+	bool bMixed = (FamilyMixed == eFamily);
+
+	/* Host and device timing either side of the default tolerances */
+	if ((FamilyJitter == eFamily) || bMixed)
+	{
+		signal.SetJitter(3, 30, uiSeed);
+	}
+
+	for (U32 i = 0; i < mTransactionsPerCapture; i++)
+	{
+		bool bShortIdle = (FamilyBackToBack == eFamily) || (bMixed && (0 == (random() % 2)));
+		bool bTruncate = ((FamilyTruncated == eFamily) && (0 == (random() % 2))) || (bMixed && (0 == (random() % 8)));
+		bool bReset = ((FamilyResets == eFamily) && (0 == (random() % 4))) || (bMixed && (0 == (random() % 16)));
+
+		/* A reset may also cut a transaction short */
+		bool bResetWithin = bReset && (0 == (random() % 2));
+		double dIdleUs = bResetWithin ? 0 : (bShortIdle ? (10 + (random() % 300)) : (1000 + (random() % 10000)));
+
+		RandomTransaction(signal, random, bTruncate || bResetWithin, dIdleUs);
+		if (bReset) signal.GlobalReset();
+	}
+
+	/* Glitches anywhere, including right beside edges */
+	if ((FamilyGlitches == eFamily) || bMixed)
+	{
+		signal.AddGlitches(bMixed ? 32 : 8, 6, 0, uiSeed);
+	}
+
+	std::ostringstream name;
+	name << mFamilyNames[eFamily] << " seed " << uiSeed;
+	pCapture->name = name.str();
+	pCapture->uiSampleRate = mSampleRate;
+	pCapture->eInitial = BIT_HIGH;
+	pCapture->auiEdges = signal.GetEdges();
+	pCapture->bNominalDeviceTiming = (FamilyJitter != eFamily) && (FamilyGlitches != eFamily) && !bMixed;
+}
+
+/* Simulate capture with faults injected */
+static void SimulateCapture(ADBCapture* pCapture)
+{
+	ADBTestAnalyzer analyzer;
+	analyzer.GetSettings().mSimulationFaults = mSimulationFaults;
+	analyzer.Simulate(mSampleRate, mSimulationSamples, &pCapture->eInitial, &pCapture->auiEdges);
+
+	pCapture->name = "simulation";
+	pCapture->uiSampleRate = mSampleRate;
+	pCapture->bNominalDeviceTiming = false;
+}
+
+/* Record result of comparison, returning whether results matched */
+static bool Check(const ADBCapture& capture, const char* pszPath, ADBAnalyzerResults& reference, ADBAnalyzerResults& other)
+{
+	guiComparisons++;
+
+	std::string difference = CompareResults(reference, other);
+	if (difference.empty()) return true;
+
+	printf("FAIL: %s, %s: %s\n", capture.name.c_str(), pszPath, difference.c_str());
+	return false;
+}
+
+/* Compare re-decoding with each replay setting against a fresh decode with it */
+static bool CheckReplay(const ADBCapture& capture)
+{
+	bool bPass = true;
+	ADBTestAnalyzer incremental;
+
+	for (size_t i = 0; i < (sizeof(mReplaySettings) / sizeof(mReplaySettings[0])); i++)
+	{
+		ApplySettings(incremental, mReplaySettings[i], capture.uiSampleRate);
+		incremental.Decode(capture.uiSampleRate, capture.eInitial, capture.auiEdges);
+
+		ADBTestAnalyzer reference;
+		ApplySettings(reference, mReplaySettings[i], capture.uiSampleRate);
+		reference.Decode(capture.uiSampleRate, capture.eInitial, capture.auiEdges);
+
+		std::ostringstream path;
+		path << "incremental replay, settings " << i;
+		bPass = Check(capture, path.str().c_str(), reference.GetResults(), incremental.GetResults()) && bPass;
+
+		/* Settings repeated must replay (so the optimised path is the one compared) */
+		if ((i > 0) && (0 == memcmp(&mReplaySettings[i], &mReplaySettings[i - 1], sizeof(mReplaySettings[i])))
+			&& (reference.GetLoggedSegments() > 1) && (0 == incremental.GetReplayedSegments()))
+		{
+			printf("FAIL: %s, %s: nothing replayed\n", capture.name.c_str(), path.str().c_str());
+			bPass = false;
+		}
+	}
+
+	return bPass;
+}
+
+/* Compare decoding with the glitch filter over added glitches against decoding without either */
+static bool CheckGlitchFilter(const ADBCapture& capture, U32 uiSeed)
+{
+	/* Glitches are only ignored entirely if far enough from real edges, every pulse in the capture must outlast the filter */
+	U64 uiFilterSamples = (U64(GlitchFilterNs(capture.uiSampleRate)) * capture.uiSampleRate) / 1000000000ull;
+	bool bEndsHigh = ((capture.auiEdges.size() & 1) == 0) == (BIT_HIGH == capture.eInitial);
+	if (!bEndsHigh) return true;
+	for (size_t i = 1; i < capture.auiEdges.size(); i++)
+	{
+		if ((capture.auiEdges[i] - capture.auiEdges[i - 1]) < uiFilterSamples) return true;
+	}
+
+	/*
+	** The filter looks an edge further ahead before accepting one, so end the capture
+	** with short pulses, idle enough to decode as nothing, that the last edge of the
+	** capture is decoded either way
+	*/
+	ADBTestSignal clean(capture.uiSampleRate);
+	clean.SetEdges(capture.auiEdges);
+	clean.Idle(10000);
+	clean.Cycle(100, 10000);
+	clean.Cycle(100, 10000);
+
+	ADBTestSignal glitches(capture.uiSampleRate);
+	glitches.SetEdges(clean.GetEdges());
+	glitches.AddGlitches(4, uiFilterSamples - 1, uiFilterSamples, uiSeed);
+
+	ADBTestAnalyzer reference;
+	reference.Decode(capture.uiSampleRate, capture.eInitial, clean.GetEdges());
+
+	ADBTestAnalyzer filtered;
+	filtered.GetSettings().mGlitchFilterNs = GlitchFilterNs(capture.uiSampleRate);
+	filtered.Decode(capture.uiSampleRate, capture.eInitial, glitches.GetEdges());
+
+	return Check(capture, "glitch filter", reference.GetResults(), filtered.GetResults());
+}
+
+/* Compare adaptive device timing against fixed timing, where device timing is nominal */
+static bool CheckAdaptiveTiming(const ADBCapture& capture)
+{
+	if (!capture.bNominalDeviceTiming) return true;
+
+	ADBTestAnalyzer reference;
+	reference.Decode(capture.uiSampleRate, capture.eInitial, capture.auiEdges);
+
+	ADBTestAnalyzer adaptive;
+	adaptive.GetSettings().mAdaptiveDeviceTiming = true;
+	adaptive.Decode(capture.uiSampleRate, capture.eInitial, capture.auiEdges);
+
+	return Check(capture, "adaptive timing", reference.GetResults(), adaptive.GetResults());
+}
+
+/* Run every check over capture, writing it out if one fails */
+static void CheckCapture(const ADBCapture& capture, U32 uiSeed)
+{
+	guiCaptures++;
+
+	bool bPass = CheckReplay(capture);
+	bPass = CheckGlitchFilter(capture, uiSeed) && bPass;
+	bPass = CheckAdaptiveTiming(capture) && bPass;
+
+	if (!bPass)
+	{
+		guiFailures++;
+
+		std::string path = "adb_differential_failure_" + std::to_string(guiFailures) + ".edges";
+		if (WriteCapture(capture, path)) printf("  capture written to %s\n", path.c_str());
+	}
+}
+
+int main(int argc, char** argv)
+{
+	U32 uiSeeds = mDefaultSeeds;
+	const char* pszCorpusDir = NULL;
+	std::vector<const char*> apszCorpus;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if ((0 == strcmp(argv[i], "-s")) && ((i + 1) < argc))
+		{
+			uiSeeds = U32(strtoul(argv[++i], NULL, 10));
+		}
+		else if ((0 == strcmp(argv[i], "-w")) && ((i + 1) < argc))
+		{
+			pszCorpusDir = argv[++i];
+		}
+		else if ('-' != argv[i][0])
+		{
+			apszCorpus.push_back(argv[i]);
+		}
+		else
+		{
+			fprintf(stderr, "usage: adb_differential_test [-s <seeds>] [-w <corpus dir>] [corpus files...]\n");
+			return 2;
+		}
+	}
+
+	ADBCapture capture;
+
+	/* Write corpus of a capture from each source */
+	if (NULL != pszCorpusDir)
+	{
+		for (U32 i = 0; i <= NumFamilies; i++)
+		{
+			std::string path = std::string(pszCorpusDir) + "/";
+			if (i < NumFamilies)
+			{
+				GenerateCapture(ADBFamily(i), 0, &capture);
+				path += mFamilyNames[i];
+			}
+			else
+			{
+				SimulateCapture(&capture);
+				path += "simulation";
+			}
+			path += ".edges";
+
+			if (!WriteCapture(capture, path))
+			{
+				fprintf(stderr, "adb_differential_test: can't write %s\n", path.c_str());
+				return 2;
+			}
+		}
+	}
+
+	/* Corpus kept for regression runs */
+	for (size_t i = 0; i < apszCorpus.size(); i++)
+	{
+		if (!ReadCapture(apszCorpus[i], &capture))
+		{
+			fprintf(stderr, "adb_differential_test: can't read %s\n", apszCorpus[i]);
+			return 2;
+		}
+		CheckCapture(capture, 0);
+	}
+
+	/* Generated captures */
+	for (U32 uiSeed = 0; uiSeed < uiSeeds; uiSeed++)
+	{
+		for (U32 i = 0; i < NumFamilies; i++)
+		{
+			GenerateCapture(ADBFamily(i), uiSeed, &capture);
+			CheckCapture(capture, uiSeed);
+		}
+	}
+
+	SimulateCapture(&capture);
+	CheckCapture(capture, 0);
+
+	printf("%u captures (%u from corpus), %u comparisons, %u captures failed\n",
+		guiCaptures, U32(apszCorpus.size()), guiComparisons, guiFailures);
+
+	return (0 == guiFailures) ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+/*
+** Compressed export test. A capture long enough to pass through the compressor
+** as many blocks, more than its queue holds, is exported both as CSV and as
+** compressed CSV. Inflating the compressed file must give exactly the CSV,
+** showing blocks are compressed whole and in order. Also checks where plain
+** CSV goes should compression fail. Only built with zlib.
+*/
+
+#pragma warning(push, 0)
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <zlib.h>
+#pragma warning(pop)
+
+#include "ADBTestAnalyzer.h"
+#include "ADBTestSignal.h"
+#include "ADBExportCompressor.h"
+
+static const U32 mSampleRate = 2000000;
+static const U32 mNumTransactions = 100000;
+
+static const char mCsvPath[] = "adb_export_test.csv";
+static const char mCompressedPath[] = "adb_export_test.csv.gz";
+
+/* Read whole file, returns false if it can't be read */
+static bool ReadFile(const char* pszPath, std::string* pContents)
+{
+	FILE* f = fopen(pszPath, "rb");
+	if (NULL == f) return false;
+
+	char acBuffer[64 * 1024];
+	size_t uiRead;
+	pContents->clear();
+	while ((uiRead = fread(acBuffer, 1, sizeof(acBuffer), f)) > 0) pContents->append(acBuffer, uiRead);
+	fclose(f);
+
+	return true;
+}
+
+/* Inflate gzip stream, returns false if it isn't a single complete stream */
+static bool Inflate(const std::string& compressed, std::string* pInflated)
+{
+	z_stream stream;
+	memset(&stream, 0, sizeof(stream));
+	if (Z_OK != inflateInit2(&stream, 15 + 16)) return false;
+
+	stream.next_in = (Bytef*)compressed.data();
+	stream.avail_in = uInt(compressed.size());
+
+	std::vector<U8> output(64 * 1024);
+	int iResult;
+	pInflated->clear();
+	do
+	{
+		stream.next_out = &output[0];
+		stream.avail_out = uInt(output.size());
+		iResult = inflate(&stream, Z_NO_FLUSH);
+		pInflated->append((const char*)&output[0], output.size() - stream.avail_out);
+	}
+	while (Z_OK == iResult);
+
+	/* Everything must have been consumed by the one stream */
+	bool bComplete = (Z_STREAM_END == iResult) && (0 == stream.avail_in);
+	inflateEnd(&stream);
+
+	return bComplete;
+}
+
+/* Check plain CSV path for a compressed export path */
+static bool CheckUncompressedPath(const char* pszFile, const char* pszExpected)
+{
+	std::string path = ADBAnalyzerResults::UncompressedExportPath(pszFile);
+	if (path == pszExpected) return true;
+
+	printf("FAIL: plain CSV for %s goes to %s, expected %s\n", pszFile, path.c_str(), pszExpected);
+	return false;
+}
+
+int main()
+{
+	/* Talks and listens of random length and data, some carrying a service request */
+	ADBTestSignal signal(mSampleRate);
+	std::mt19937 random(1);
+	signal.Idle(1000);
+	for (U32 i = 0; i < mNumTransactions; i++)
+	{
+		U8 abyData[7];
+		U8 uiDataLen = U8(2 + (random() % 6));
+		for (U8 j = 0; j < uiDataLen; j++) abyData[j] = U8(random());
+
+		U8 byCommand = U8(((1 + (random() % 15)) << 4) | ((random() & 1) ? 0x0C : 0x08) | (random() % 4));
+		signal.Transaction(byCommand, abyData, uiDataLen, 0 == (random() % 8), 1000);
+	}
+
+	ADBTestAnalyzer analyzer;
+	analyzer.GetSettings().mDecodePayloads = true;
+	analyzer.Decode(mSampleRate, BIT_HIGH, signal.GetEdges());
+
+	analyzer.GetResults().GenerateExportFile(mCsvPath, Decimal, ExportCsv);
+	analyzer.GetResults().GenerateExportFile(mCompressedPath, Decimal, ExportCsvCompressed);
+
+	bool bPass = true;
+	std::string csv;
+	std::string compressed;
+	std::string inflated;
+	if (!ReadFile(mCsvPath, &csv) || !ReadFile(mCompressedPath, &compressed))
+	{
+		printf("FAIL: exports couldn't be read back\n");
+		bPass = false;
+	}
+	else if (!Inflate(compressed, &inflated))
+	{
+		printf("FAIL: compressed export isn't a complete gzip stream\n");
+		bPass = false;
+	}
+	else if (inflated != csv)
+	{
+		size_t uiAt = 0;
+		while ((uiAt < csv.size()) && (uiAt < inflated.size()) && (csv[uiAt] == inflated[uiAt])) uiAt++;
+		printf("FAIL: compressed export differs from CSV export at byte %llu (%llu bytes inflated, %llu expected)\n",
+			(unsigned long long)uiAt, (unsigned long long)inflated.size(), (unsigned long long)csv.size());
+		bPass = false;
+	}
+
+	/* Enough output to fill the compressor's queue many times over */
+	U64 uiFrames = analyzer.GetResults().GetNumFrames();
+	U64 uiBlocks = (uiFrames + ADBAnalyzerResults::mExportChunkFrames - 1) / ADBAnalyzerResults::mExportChunkFrames;
+	printf("%llu frames exported as %llu blocks, %llu bytes of CSV compressed to %llu\n",
+		(unsigned long long)uiFrames, (unsigned long long)uiBlocks, (unsigned long long)csv.size(), (unsigned long long)compressed.size());
+	if (uiBlocks <= (2 * ADBExportCompressor::mMaxQueuedBlocks))
+	{
+		printf("FAIL: too few blocks to fill the compressor's queue\n");
+		bPass = false;
+	}
+
+	bPass = CheckUncompressedPath("export.csv.gz", "export.csv") && bPass;
+	bPass = CheckUncompressedPath("export.gz", "export.csv") && bPass;
+	bPass = CheckUncompressedPath("dir.d/export.gz", "dir.d/export.csv") && bPass;
+	bPass = CheckUncompressedPath("export.txt", "export.txt") && bPass;
+
+	remove(mCsvPath);
+	remove(mCompressedPath);
+
+	return bPass ? 0 : 1;
+}
@@ -0,0 +1,226 @@
+/*
+** Live stream test, consuming records over a Unix domain socket as a consumer
+** would. Transactions of a known capture must arrive in order, with their
+** samples, command, data and flags intact, tagged with the decode generation.
+** Decoding again with the consumer still connected must restart sequence
+** numbers under the next generation, records still queued from the previous
+** decode being told apart by theirs.
+*/
+
+#pragma warning(push, 0)
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#pragma warning(pop)
+
+#include "ADBTestAnalyzer.h"
+#include "ADBTestSignal.h"
+#include "ADBTransactionStream.h"
+
+static const U32 mSampleRate = 2000000;
+static const U32 mNumTransactions = 50;
+
+/* Longest wait for a record */
+static const int mRecordTimeoutMs = 5000;
+
+/* Transaction expected in the stream */
+struct ADBExpectedRecord
+{
+	U8 byCommand;
+	U8 abyData[8];
+	U8 uiDataLen;
+	bool bServiceRequest;
+	U64 uiStart;
+	U64 uiEnd;
+};
+
+/* Record as received */
+struct ADBStreamRecord
+{
+	U32 uiSequence;
+	U32 uiDrops;
+	U64 uiStart;
+	U64 uiEnd;
+	U32 uiSampleRate;
+	U8 byCommand;
+	U8 uiDataLen;
+	U8 byFlags;
+	U8 uiGeneration;
+	U8 abyData[8];
+};
+
+static U32 LoadU32(const U8 *pabySrc)
+{
+	U32 uiValue = 0;
+	for (int i = 3; i >= 0; i--) uiValue = (uiValue << 8) | pabySrc[i];
+	return uiValue;
+}
+
+static U64 LoadU64(const U8 *pabySrc)
+{
+	U64 uiValue = 0;
+	for (int i = 7; i >= 0; i--) uiValue = (uiValue << 8) | pabySrc[i];
+	return uiValue;
+}
+
+/* Read next record, returning false if none arrives in time */
+static bool ReadRecord(int iSocket, ADBStreamRecord* pRecord, int iTimeoutMs)
+{
+	U8 abyRecord[ADBTransactionStream::mRecordSize];
+	size_t uiReceived = 0;
+	while (uiReceived < sizeof(abyRecord))
+	{
+		pollfd fd = {iSocket, POLLIN, 0};
+		if (poll(&fd, 1, iTimeoutMs) <= 0) return false;
+
+		ssize_t iRead = recv(iSocket, &abyRecord[uiReceived], sizeof(abyRecord) - uiReceived, 0);
+		if (iRead <= 0) return false;
+		uiReceived += size_t(iRead);
+	}
+
+	pRecord->uiSequence = LoadU32(&abyRecord[0]);
+	pRecord->uiDrops = LoadU32(&abyRecord[4]);
+	pRecord->uiStart = LoadU64(&abyRecord[8]);
+	pRecord->uiEnd = LoadU64(&abyRecord[16]);
+	pRecord->uiSampleRate = LoadU32(&abyRecord[24]);
+	pRecord->byCommand = abyRecord[28];
+	pRecord->uiDataLen = abyRecord[29];
+	pRecord->byFlags = abyRecord[30];
+	pRecord->uiGeneration = abyRecord[31];
+	memcpy(pRecord->abyData, &abyRecord[32], sizeof(pRecord->abyData));
+	return true;
+}
+
+/* Build capture of known transactions, with one more after them that needn't be published */
+static void BuildCapture(std::vector<U64>* pauiEdges, std::vector<ADBExpectedRecord>* pExpected)
+{
+	ADBTestSignal signal(mSampleRate);
+	static const U8 abyCommands[] = {0x3C, 0x2B, 0x31, 0x2C, 0x3F};
+
+	for (U32 i = 0; i <= mNumTransactions; i++)
+	{
+		ADBExpectedRecord expected;
+		memset(&expected, 0, sizeof(expected));
+		expected.byCommand = abyCommands[i % sizeof(abyCommands)];
+		expected.uiDataLen = ADBTestSignal::IsTalk(expected.byCommand) || (0x08 == (expected.byCommand & 0x0C)) ? U8(2 + (i % 6)) : 0;
+		expected.bServiceRequest = (0 == (i % 3));
+		for (U8 j = 0; j < expected.uiDataLen; j++) expected.abyData[j] = U8((i * 37) + j);
+
+		/* Transaction spans attention pulse to start of final stop bit */
+		expected.uiStart = signal.GetSample();
+		signal.Transaction(expected.byCommand, expected.abyData, expected.uiDataLen, expected.bServiceRequest, 5000);
+		expected.uiEnd = signal.GetEdges()[signal.GetEdges().size() - 2];
+
+		if (i < mNumTransactions) pExpected->push_back(expected);
+	}
+
+	*pauiEdges = signal.GetEdges();
+}
+
+/* Check records of a decode arrive as expected, skipping any of the previous decode */
+static bool CheckDecode(int iSocket, U8 uiPrevGeneration, const std::vector<ADBExpectedRecord>& expected, U8* puiGeneration)
+{
+	ADBStreamRecord record;
+	do
+	{
+		if (!ReadRecord(iSocket, &record, mRecordTimeoutMs))
+		{
+			printf("FAIL: no record of decode after generation %u\n", uiPrevGeneration);
+			return false;
+		}
+	} while (record.uiGeneration == uiPrevGeneration);
+
+	if (record.uiGeneration != U8(uiPrevGeneration + 1))
+	{
+		printf("FAIL: generation %u followed %u\n", record.uiGeneration, uiPrevGeneration);
+		return false;
+	}
+	*puiGeneration = record.uiGeneration;
+
+	for (U32 i = 0; i < expected.size(); i++)
+	{
+		if ((i > 0) && !ReadRecord(iSocket, &record, mRecordTimeoutMs))
+		{
+			printf("FAIL: record %u of generation %u missing\n", i, *puiGeneration);
+			return false;
+		}
+
+		const ADBExpectedRecord& e = expected[i];
+		if (   (record.uiSequence != i) || (0 != record.uiDrops) || (record.uiGeneration != *puiGeneration)
+			|| (record.uiSampleRate != mSampleRate) || (record.uiStart != e.uiStart) || (record.uiEnd != e.uiEnd)
+			|| (record.byCommand != e.byCommand) || (record.uiDataLen != e.uiDataLen)
+			|| (record.byFlags != (e.bServiceRequest ? 0x01 : 0x00)) || (0 != memcmp(record.abyData, e.abyData, sizeof(e.abyData))))
+		{
+			printf("FAIL: record %u (generation %u): sequence %u drops %u rate %u samples %llu-%llu command 0x%02X length %u flags 0x%02X,"
+				   " expected samples %llu-%llu command 0x%02X length %u\n",
+				i, record.uiGeneration, record.uiSequence, record.uiDrops, record.uiSampleRate,
+				(unsigned long long)record.uiStart, (unsigned long long)record.uiEnd, record.byCommand, record.uiDataLen, record.byFlags,
+				(unsigned long long)e.uiStart, (unsigned long long)e.uiEnd, e.byCommand, e.uiDataLen);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main()
+{
+	std::string path = "/tmp/adb_stream_test_" + std::to_string(getpid()) + ".sock";
+
+	std::vector<U64> auiEdges;
+	std::vector<ADBExpectedRecord> expected;
+	BuildCapture(&auiEdges, &expected);
+
+	ADBTestAnalyzer analyzer;
+	analyzer.GetSettings().mStreamPath = path;
+
+	/* First decode opens the endpoint, nobody is connected to see it */
+	analyzer.Decode(mSampleRate, BIT_HIGH, auiEdges);
+
+	int iSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	memcpy(addr.sun_path, path.c_str(), path.size());
+	if ((iSocket < 0) || (0 != connect(iSocket, (sockaddr*)&addr, sizeof(addr))))
+	{
+		printf("FAIL: can't connect to %s\n", path.c_str());
+		return 1;
+	}
+
+	/* Decode until the consumer has been accepted and records arrive */
+	ADBStreamRecord record;
+	bool bConnected = false;
+	for (U32 i = 0; (i < 100) && !bConnected; i++)
+	{
+		analyzer.Decode(mSampleRate, BIT_HIGH, auiEdges);
+		bConnected = ReadRecord(iSocket, &record, 50);
+	}
+	if (!bConnected)
+	{
+		printf("FAIL: no records after connecting\n");
+		return 1;
+	}
+
+	/* Drain what's left, the last record belongs to the last decode */
+	while (ReadRecord(iSocket, &record, 200)) {}
+
+	/* Decode again twice, each one's records following the last under the next generation */
+	bool bPass = true;
+	U8 uiGeneration = record.uiGeneration;
+	for (U32 i = 0; (i < 2) && bPass; i++)
+	{
+		analyzer.Decode(mSampleRate, BIT_HIGH, auiEdges);
+		bPass = CheckDecode(iSocket, uiGeneration, expected, &uiGeneration);
+	}
+
+	close(iSocket);
+
+	printf("%s: %u transactions per decode, last generation %u\n", bPass ? "PASS" : "FAIL", U32(expected.size()), uiGeneration);
+	return bPass ? 0 : 1;
+}
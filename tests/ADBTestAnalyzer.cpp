@@ -0,0 +1,45 @@
+#include "ADBTestAnalyzer.h"
+
+ADBTestAnalyzer::ADBTestAnalyzer()
+	: mRetainResults(true)
+{
+	mSettings->mInputChannel = Channel(0, 0);
+}
+
+void ADBTestAnalyzer::Decode(U32 uiSampleRate, BitState eInitial, const std::vector<U64>& auiEdges)
+{
+	mChannelData.StubSetEdges(eInitial, auiEdges);
+	Run(uiSampleRate);
+}
+
+void ADBTestAnalyzer::Decode(U32 uiSampleRate, BitState eInitial, StubEdgeSource* pSource)
+{
+	mChannelData.StubSetSource(eInitial, pSource);
+	Run(uiSampleRate);
+}
+
+void ADBTestAnalyzer::Simulate(U32 uiSampleRate, U64 uiNumSamples, BitState* peInitial, std::vector<U64>* pauiEdges)
+{
+	StubSetChannelData(NULL, uiSampleRate);
+
+	SimulationChannelDescriptor* pSimulation;
+	GenerateSimulationData(uiNumSamples, uiSampleRate, &pSimulation);
+	*peInitial = pSimulation->mInitialBitState;
+	*pauiEdges = pSimulation->mEdges;
+}
+
+void ADBTestAnalyzer::Run(U32 uiSampleRate)
+{
+	StubSetChannelData(&mChannelData, uiSampleRate);
+	SetupResults();
+	mResults->StubSetRetainResults(mRetainResults);
+
+	try
+	{
+		WorkerThread();
+	}
+	catch (StubEndOfData&)
+	{
+		/* Whole capture decoded */
+	}
+}
@@ -0,0 +1,52 @@
+#ifndef ADB_TEST_ANALYZER
+#define ADB_TEST_ANALYZER
+
+#pragma warning(push, 0)
+#include <vector>
+#pragma warning(pop)
+
+#include <AnalyzerChannelData.h>
+#include "ADBAnalyzer.h"
+#include "ADBAnalyzerSettings.h"
+#include "ADBAnalyzerResults.h"
+
+/*
+** Analyzer run directly by tests against the stub SDK, giving access to its
+** settings, results and decode log. Each decode sets up fresh results as the
+** SDK does on a rerun, the log of the previous decode being kept for reuse.
+*/
+class ADBTestAnalyzer : public ADBAnalyzer
+{
+	public:
+		ADBTestAnalyzer();
+
+		/* Decode capture of edges, bus in given state before the first */
+		void Decode(U32 uiSampleRate, BitState eInitial, const std::vector<U64>& auiEdges);
+
+		/* Decode capture supplied by source */
+		void Decode(U32 uiSampleRate, BitState eInitial, StubEdgeSource* pSource);
+
+		/* Simulate capture of given length with current settings */
+		void Simulate(U32 uiSampleRate, U64 uiNumSamples, BitState* peInitial, std::vector<U64>* pauiEdges);
+
+		/* Keep results for inspection (default), or only count them */
+		void SetRetainResults(bool bRetain) { mRetainResults = bRetain; }
+
+		ADBAnalyzerSettings& GetSettings() { return *mSettings; }
+		ADBAnalyzerResults& GetResults() { return *mResults; }
+
+		/* Segments the latest decode logged, zero if it couldn't be logged */
+		size_t GetLoggedSegments() const { return mDecodeLog.GetNumSegments(); }
+
+		/* Segments the latest decode reused from the previous one */
+		size_t GetReplayedSegments() const { return mReplayedSegments; }
+
+	protected:
+		/* Set up results and run worker thread until the channel runs out */
+		void Run(U32 uiSampleRate);
+
+		AnalyzerChannelData mChannelData;
+		bool mRetainResults;
+};
+
+#endif // ADB_TEST_ANALYZER
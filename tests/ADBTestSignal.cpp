@@ -0,0 +1,165 @@
+#include "ADBTestSignal.h"
+
+#pragma warning(push, 0)
+#include <algorithm>
+#pragma warning(pop)
+
+ADBTestSignal::ADBTestSignal(U32 uiSampleRate)
+	: mSampleRate(uiSampleRate), mSample(0), mHostJitterPct(0.0), mDeviceJitterPct(0.0)
+{
+	/* Idle before first output */
+	Idle(100);
+}
+
+void ADBTestSignal::SetJitter(double dHostPct, double dDevicePct, U32 uiSeed)
+{
+	mHostJitterPct = dHostPct;
+	mDeviceJitterPct = dDevicePct;
+	mRandom.seed(uiSeed);
+}
+
+void ADBTestSignal::Idle(double dUs)
+{
+	mSample += UsToSamples(dUs);
+}
+
+void ADBTestSignal::Cycle(double dLowUs, double dHighUs)
+{
+	mEdges.push_back(mSample);
+	mSample += UsToSamples(dLowUs);
+	mEdges.push_back(mSample);
+	mSample += UsToSamples(dHighUs);
+}
+
+void ADBTestSignal::Attention()
+{
+	JitteredCycle(800, 65, false);
+}
+
+void ADBTestSignal::Bits(U8 byValue, U32 uiNumBits, bool bDevice)
+{
+	for (U32 i = 0; i < uiNumBits; i++)
+	{
+		/* One is short low, long high, zero the reverse */
+		if (byValue & (0x80 >> i))
+		{
+			JitteredCycle(35, 65, bDevice);
+		}
+		else
+		{
+			JitteredCycle(65, 35, bDevice);
+		}
+	}
+}
+
+void ADBTestSignal::Stop(bool bServiceRequest, bool bDevice)
+{
+	if (bServiceRequest)
+	{
+		JitteredCycle(300, 0, true);
+	}
+	else
+	{
+		JitteredCycle(70, 0, bDevice);
+	}
+}
+
+void ADBTestSignal::Transaction(U8 byCommand, const U8 *pabyData, U8 uiDataLen, bool bServiceRequest, double dIdleUs)
+{
+	bool bDevice = IsTalk(byCommand);
+
+	/* Command and stop bit */
+	Attention();
+	Byte(byCommand, false);
+	Stop(bServiceRequest, false);
+
+	if (uiDataLen > 0)
+	{
+		/* Stop to start, start bit, data and stop bit */
+		Idle(200);
+		Bits(0x80, 1, bDevice);
+		for (U8 i = 0; i < uiDataLen; i++) Byte(pabyData[i], bDevice);
+		Stop(false, bDevice);
+	}
+
+	Idle(dIdleUs);
+}
+
+void ADBTestSignal::TruncatedTransaction(U8 byCommand, const U8 *pabyData, U8 uiDataLen, U32 uiNumBits, double dIdleUs)
+{
+	bool bDevice = IsTalk(byCommand);
+
+	/* Command, as far as it goes */
+	Attention();
+	U32 uiBits = std::min<U32>(uiNumBits, 8);
+	Bits(byCommand, uiBits, false);
+	uiNumBits -= uiBits;
+
+	if (uiNumBits > 0)
+	{
+		/* Stop bit, stop to start, start bit, then data as far as it goes */
+		Stop(false, false);
+		Idle(200);
+		Bits(0x80, 1, bDevice);
+		for (U8 i = 0; (i < uiDataLen) && (uiNumBits > 0); i++)
+		{
+			uiBits = std::min<U32>(uiNumBits, 8);
+			Bits(pabyData[i], uiBits, bDevice);
+			uiNumBits -= uiBits;
+		}
+	}
+
+	Idle(dIdleUs);
+}
+
+void ADBTestSignal::GlobalReset()
+{
+	Cycle(4000, 1000);
+}
+
+void ADBTestSignal::AddGlitches(U32 uiOneIn, U64 uiMaxWidth, U64 uiClearance, U32 uiSeed)
+{
+	std::mt19937 random(uiSeed);
+	U64 uiClear = std::max<U64>(uiClearance, 1);
+
+	std::vector<U64> auiEdges;
+	auiEdges.reserve(mEdges.size() + (mEdges.size() / 4));
+	for (size_t i = 0; i < mEdges.size(); i++)
+	{
+		auiEdges.push_back(mEdges[i]);
+		if ((i + 1) >= mEdges.size()) break;
+		if (0 != (random() % uiOneIn)) continue;
+
+		/* Glitch within period, clear of its edges */
+		U64 uiWidth = 1 + (random() % uiMaxWidth);
+		U64 uiPeriod = mEdges[i + 1] - mEdges[i];
+		if (uiPeriod < ((2 * uiClear) + uiWidth + 1)) continue;
+
+		U64 uiStart = mEdges[i] + uiClear + (random() % (uiPeriod - (2 * uiClear) - uiWidth));
+		auiEdges.push_back(uiStart);
+		auiEdges.push_back(uiStart + uiWidth);
+	}
+
+	mEdges.swap(auiEdges);
+}
+
+void ADBTestSignal::JitteredCycle(double dLowUs, double dHighUs, bool bDevice)
+{
+	Cycle(Jitter(dLowUs, bDevice), Jitter(dHighUs, bDevice));
+}
+
+double ADBTestSignal::Jitter(double dUs, bool bDevice)
+{
+	double dPct = bDevice ? mDeviceJitterPct : mHostJitterPct;
+	if (0.0 == dPct) return dUs;
+
+	/* Close to the percentage either way, spread by a tenth of it */
+	double dSpread = 0.9 + (0.2 * (mRandom() / 4294967296.0));
+	double dSign = (mRandom() & 1) ? 1.0 : -1.0;
+	return dUs * (1.0 + ((dSign * dPct * dSpread) / 100.0));
+}
+
+U64 ADBTestSignal::UsToSamples(double dUs) const
+{
+	return U64((mSampleRate * dUs) / 1000000.0);
+}
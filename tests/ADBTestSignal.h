@@ -0,0 +1,99 @@
+#ifndef ADB_TEST_SIGNAL
+#define ADB_TEST_SIGNAL
+
+#pragma warning(push, 0)
+#include <random>
+#include <vector>
+#pragma warning(pop)
+
+#include <LogicPublicTypes.h>
+
+/*
+** Builds the edges of an ADB bus for tests, transaction by transaction. The bus
+** is high before the first edge. Periods are given in microseconds and rounded
+** to samples one at a time, as the simulation data generator does. Faults are
+** built from the same parts: jittered periods, transactions cut short, glitches
+** and resets.
+*/
+class ADBTestSignal
+{
+	public:
+		ADBTestSignal(U32 uiSampleRate);
+
+		/* Edges so far */
+		const std::vector<U64>& GetEdges() const { return mEdges; }
+
+		/* Drop edges so far (keeping capacity), carrying on from the same point */
+		void ClearEdges() { mEdges.clear(); }
+
+		/* Replace edges so far, with those of a capture from elsewhere */
+		void SetEdges(const std::vector<U64>& auiEdges) { mEdges = auiEdges; mSample = auiEdges.empty() ? mSample : auiEdges.back(); }
+
+		/* Sample reached */
+		U64 GetSample() const { return mSample; }
+
+		/*
+		** Deviate every following host and device period by close to the given
+		** percentage (within a tenth of it), longer or shorter at random. Zero
+		** gives nominal timing.
+		*/
+		void SetJitter(double dHostPct, double dDevicePct, U32 uiSeed);
+
+		/* Hold bus in its current state */
+		void Idle(double dUs);
+
+		/* Drive bus low, then release it high (never jittered) */
+		void Cycle(double dLowUs, double dHighUs);
+
+		/* Attention and sync from host */
+		void Attention();
+
+		/* Output most significant bits of value from host or device */
+		void Bits(U8 byValue, U32 uiNumBits, bool bDevice);
+
+		/* Output byte, most significant bit first */
+		void Byte(U8 byValue, bool bDevice) { Bits(byValue, 8, bDevice); }
+
+		/* Stop bit, a service request from the device holding it low */
+		void Stop(bool bServiceRequest, bool bDevice);
+
+		/* Output transaction, then idle */
+		void Transaction(U8 byCommand, const U8 *pabyData, U8 uiDataLen, bool bServiceRequest, double dIdleUs);
+
+		/* Output transaction abandoned after the given number of command and data bits, then idle */
+		void TruncatedTransaction(U8 byCommand, const U8 *pabyData, U8 uiDataLen, U32 uiNumBits, double dIdleUs);
+
+		/* Hold bus low for a global reset, then release it */
+		void GlobalReset();
+
+		/*
+		** Insert a glitch into one in every so many periods between edges so far,
+		** of 1 to max width samples, and at least clearance samples from either
+		** edge of the period. Periods too short to hold it are left alone.
+		*/
+		void AddGlitches(U32 uiOneIn, U64 uiMaxWidth, U64 uiClearance, U32 uiSeed);
+
+		/* Whether data of command is sent by device */
+		static bool IsTalk(U8 byCommand) { return 0x0C == (byCommand & 0x0C); }
+
+	protected:
+		/* Drive bus low, then release it high, jittered as for host or device */
+		void JitteredCycle(double dLowUs, double dHighUs, bool bDevice);
+
+		/* Apply jitter to period */
+		double Jitter(double dUs, bool bDevice);
+
+		/* Convert microseconds to sample count */
+		U64 UsToSamples(double dUs) const;
+
+		U32 mSampleRate;
+		U64 mSample;
+		std::vector<U64> mEdges;
+
+		/* Jitter as a percentage of period, and its source */
+		double mHostJitterPct;
+		double mDeviceJitterPct;
+		std::mt19937 mRandom;
+};
+
+#endif // ADB_TEST_SIGNAL
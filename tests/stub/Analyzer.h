@@ -0,0 +1,55 @@
+#ifndef ANALYZER
+#define ANALYZER
+
+#include "LogicPublicTypes.h"
+#include "AnalyzerSettings.h"
+#include "AnalyzerResults.h"
+#include "SimulationChannelDescriptor.h"
+
+class AnalyzerChannelData;
+
+/*
+** Analyzer base, run directly by tests rather than on a thread of its own. The
+** test supplies the channel data and sample rate the analyzer sees.
+*/
+class Analyzer
+{
+	public:
+		Analyzer() : mChannelData(NULL), mSampleRate(0) {}
+		virtual ~Analyzer() {}
+
+		virtual void SetupResults() {}
+		virtual void WorkerThread() = 0;
+		virtual U32 GenerateSimulationData(U64 newest_sample_requested, U32 sample_rate, SimulationChannelDescriptor** simulation_channels) = 0;
+		virtual U32 GetMinimumSampleRateHz() = 0;
+		virtual const char* GetAnalyzerName() const = 0;
+		virtual bool NeedsRerun() = 0;
+
+		/* Channel data returned for every channel, and sample rate */
+		void StubSetChannelData(AnalyzerChannelData* channel_data, U32 sample_rate) { mChannelData = channel_data; mSampleRate = sample_rate; }
+
+	protected:
+		void SetAnalyzerSettings(AnalyzerSettings* /*settings*/) {}
+		void SetAnalyzerResults(AnalyzerResults* /*results*/) {}
+		AnalyzerChannelData* GetAnalyzerChannelData(Channel& /*channel*/) { return mChannelData; }
+		void ReportProgress(U64 /*sample_number*/) {}
+		void CheckIfThreadShouldExit() {}
+		void KillThread() {}
+
+	public:
+		U32 GetSampleRate() { return mSampleRate; }
+		U32 GetSimulationSampleRate() { return mSampleRate; }
+		U64 GetTriggerSample() { return 0; }
+
+	protected:
+		AnalyzerChannelData* mChannelData;
+		U32 mSampleRate;
+};
+
+class Analyzer2 : public Analyzer
+{
+	protected:
+		void UseFrameV2() {}
+};
+
+#endif // ANALYZER
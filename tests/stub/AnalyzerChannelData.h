@@ -0,0 +1,64 @@
+#ifndef ANALYZER_CHANNEL_DATA
+#define ANALYZER_CHANNEL_DATA
+
+#include <vector>
+
+#include "LogicPublicTypes.h"
+
+/* Thrown once a channel has run out of edges, where the SDK would wait for more to be captured */
+struct StubEndOfData {};
+
+/* Supplies a channel's edges a block at a time */
+class StubEdgeSource
+{
+	public:
+		virtual ~StubEdgeSource() {}
+
+		/* Append next block of edges (ascending samples), returns false once there are none left */
+		virtual bool NextEdges(std::vector<U64>& edges) = 0;
+};
+
+/*
+** Channel data read from a list of edges, or from a source supplying them in
+** blocks so long captures run in constant memory. Edges already passed are
+** dropped as each block is used up. Running out of edges throws StubEndOfData,
+** ending the analyzer's worker thread.
+*/
+class AnalyzerChannelData
+{
+	public:
+		AnalyzerChannelData();
+
+		/* Read whole capture from list of edges */
+		void StubSetEdges(BitState initial_bit_state, const std::vector<U64>& edges);
+
+		/* Read capture from source */
+		void StubSetSource(BitState initial_bit_state, StubEdgeSource* source);
+
+		U64 GetSampleNumber() { return mSample; }
+		BitState GetBitState() { return mBitState; }
+
+		U32 Advance(U32 num_samples);
+		U32 AdvanceToAbsPosition(U64 sample_number);
+		void AdvanceToNextEdge();
+		U64 GetSampleOfNextEdge();
+
+		bool WouldAdvancingCauseTransition(U32 num_samples);
+		bool WouldAdvancingToAbsPositionCauseTransition(U64 sample_number);
+		bool DoMoreTransitionsExistInCurrentData();
+
+	protected:
+		/* Ensure next edge is held, returns false if there are none left */
+		bool HaveNextEdge();
+
+		/* Edges held, index of next one, and where they come from (NULL if all held) */
+		std::vector<U64> mEdges;
+		size_t mNextEdge;
+		StubEdgeSource* mSource;
+
+		/* Position and state there */
+		U64 mSample;
+		BitState mBitState;
+};
+
+#endif // ANALYZER_CHANNEL_DATA
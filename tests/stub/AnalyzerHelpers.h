@@ -0,0 +1,19 @@
+#ifndef ANALYZER_HELPERS
+#define ANALYZER_HELPERS
+
+#include "Analyzer.h"
+
+class AnalyzerHelpers
+{
+	public:
+		static void GetNumberString(U64 number, DisplayBase display_base, U32 num_data_bits, char* result_string, U32 result_string_max_length);
+		static void GetTimeString(U64 sample, U64 trigger_sample, U32 sample_rate_hz, char* result_string, U32 result_string_max_length);
+		static void Assert(const char* message);
+		static U64 AdjustSimulationTargetSample(U64 target_sample, U32 sample_rate, U32 simulation_sample_rate);
+
+		static void* StartFile(const char* file, bool is_binary = false);
+		static void AppendToFile(const U8* data, U32 data_length, void* file);
+		static void EndFile(void* file);
+};
+
+#endif // ANALYZER_HELPERS
@@ -0,0 +1,145 @@
+#ifndef ANALYZER_RESULTS
+#define ANALYZER_RESULTS
+
+#include <string>
+#include <vector>
+
+#include "LogicPublicTypes.h"
+
+#define INVALID_RESULT_INDEX 0xFFFFFFFFFFFFFFFFull
+
+class Frame
+{
+	public:
+		Frame() : mStartingSampleInclusive(0), mEndingSampleInclusive(0), mData1(0), mData2(0), mType(0), mFlags(0) {}
+
+		bool HasFlag(U8 flag) { return 0 != (mFlags & flag); }
+
+		S64 mStartingSampleInclusive;
+		S64 mEndingSampleInclusive;
+		U64 mData1;
+		U64 mData2;
+		U8 mType;
+		U8 mFlags;
+};
+
+/* Fields of a FrameV2, each formatted as 'key=value' */
+struct FrameV2Data
+{
+	static const U32 mMaxFields = 8;
+	static const U32 mMaxFieldLength = 64;
+
+	char acFields[mMaxFields][mMaxFieldLength];
+	U32 uiNumFields;
+};
+
+/*
+** As in the SDK, a FrameV2 holds its fields out of line, so constructing one
+** costs exactly one allocation. Adding fields allocates nothing more.
+*/
+class FrameV2
+{
+	public:
+		FrameV2();
+		~FrameV2();
+
+		void AddString(const char* key, const char* value);
+		void AddDouble(const char* key, double value);
+		void AddInteger(const char* key, S64 value);
+		void AddBoolean(const char* key, bool value);
+		void AddByte(const char* key, U8 value);
+		void AddByteArray(const char* key, const U8* data, U64 length);
+
+		FrameV2Data* mInternals;
+
+	private:
+		FrameV2(const FrameV2&);
+		FrameV2& operator=(const FrameV2&);
+};
+
+/* FrameV2 as added to results */
+struct StubFrameV2Record
+{
+	std::string type;
+	U64 uiStart;
+	U64 uiEnd;
+	std::vector<std::string> fields;
+
+	bool operator==(const StubFrameV2Record& other) const { return (type == other.type) && (uiStart == other.uiStart) && (uiEnd == other.uiEnd) && (fields == other.fields); }
+	bool operator!=(const StubFrameV2Record& other) const { return !(*this == other); }
+};
+
+/*
+** Results kept in plain lists for tests to inspect. With retention turned off
+** results are only counted, so long decodes run in constant memory and the
+** only allocations are the analyzer's own.
+*/
+class AnalyzerResults
+{
+	public:
+		enum MarkerType { Dot, ErrorDot, Square, ErrorSquare, UpArrow, DownArrow, X, ErrorX, Start, Stop, One, Zero };
+
+		AnalyzerResults();
+		virtual ~AnalyzerResults();
+
+		virtual void GenerateBubbleText(U64 frame_index, Channel& channel, DisplayBase display_base) = 0;
+		virtual void GenerateExportFile(const char* file, DisplayBase display_base, U32 export_type_user_id) = 0;
+		virtual void GenerateFrameTabularText(U64 frame_index, DisplayBase display_base) = 0;
+		virtual void GeneratePacketTabularText(U64 packet_id, DisplayBase display_base) = 0;
+		virtual void GenerateTransactionTabularText(U64 transaction_id, DisplayBase display_base) = 0;
+
+		void AddMarker(U64 sample_number, MarkerType marker_type, Channel& channel);
+		U64 AddFrame(const Frame& frame);
+		void AddFrameV2(const FrameV2& frame, const char* type, U64 starting_sample, U64 ending_sample);
+		U64 CommitPacketAndStartNewPacket();
+		void CancelPacketAndStartNewPacket();
+		void AddPacketToTransaction(U64 /*transaction_id*/, U64 /*packet_id*/) {}
+		void AddChannelBubblesWillAppearOn(const Channel& /*channel*/) {}
+		void CommitResults() {}
+
+		U64 GetNumFrames() { return mNumFrames; }
+		U64 GetNumPackets() { return mNumPackets; }
+		Frame GetFrame(U64 frame_id) { return mFrames[frame_id]; }
+		U64 GetPacketContainingFrame(U64 frame_id);
+		U64 GetPacketContainingFrameSequential(U64 frame_id) { return GetPacketContainingFrame(frame_id); }
+		void GetFramesContainedInPacket(U64 packet_id, U64* first_frame_id, U64* last_frame_id);
+
+		void ClearResultStrings() { mResultStrings.clear(); }
+		void AddResultString(const char* str1, const char* str2 = NULL, const char* str3 = NULL, const char* str4 = NULL, const char* str5 = NULL, const char* str6 = NULL);
+		void ClearTabularText() { mTabularText.clear(); }
+		void AddTabularText(const char* str1, const char* str2 = NULL, const char* str3 = NULL, const char* str4 = NULL, const char* str5 = NULL, const char* str6 = NULL);
+
+		bool UpdateExportProgressAndCheckForCancel(U64 /*completed_frames*/, U64 /*total_frames*/) { return false; }
+
+		/* Keep results in the lists below (default), or only count them */
+		void StubSetRetainResults(bool bRetain) { mRetainResults = bRetain; }
+
+		/* Markers (sample and type) */
+		struct StubMarker
+		{
+			U64 uiSample;
+			MarkerType eType;
+
+			bool operator==(const StubMarker& other) const { return (uiSample == other.uiSample) && (eType == other.eType); }
+		};
+
+		/* Results added, packets are first and last frame */
+		std::vector<Frame> mFrames;
+		std::vector<StubMarker> mMarkers;
+		std::vector<StubFrameV2Record> mFramesV2;
+		std::vector<std::pair<U64, U64> > mPackets;
+		std::vector<std::string> mResultStrings;
+		std::vector<std::string> mTabularText;
+
+		/* Counts, whether retained or not */
+		U64 mNumFrames;
+		U64 mNumMarkers;
+		U64 mNumFramesV2;
+		U64 mNumPackets;
+
+	protected:
+		bool mRetainResults;
+		U64 mPacketFirstFrame;
+};
+
+#endif // ANALYZER_RESULTS
@@ -0,0 +1,93 @@
+#ifndef ANALYZER_SETTING_INTERFACE
+#define ANALYZER_SETTING_INTERFACE
+
+#include <string>
+#include <vector>
+
+#include "LogicPublicTypes.h"
+
+/* Setting interfaces just hold their values, nothing is shown */
+class AnalyzerSettingInterface
+{
+	public:
+		virtual ~AnalyzerSettingInterface() {}
+
+		void SetTitleAndTooltip(const char* title, const char* /*tooltip*/) { mTitle = title; }
+
+		std::string mTitle;
+};
+
+class AnalyzerSettingInterfaceChannel : public AnalyzerSettingInterface
+{
+	public:
+		AnalyzerSettingInterfaceChannel() : mSelectionOfNoneIsAllowed(false) {}
+
+		Channel GetChannel() { return mChannel; }
+		void SetChannel(const Channel& channel) { mChannel = channel; }
+		bool GetSelectionOfNoneIsAllowed() { return mSelectionOfNoneIsAllowed; }
+		void SetSelectionOfNoneIsAllowed(bool is_allowed) { mSelectionOfNoneIsAllowed = is_allowed; }
+
+		Channel mChannel;
+		bool mSelectionOfNoneIsAllowed;
+};
+
+class AnalyzerSettingInterfaceNumberList : public AnalyzerSettingInterface
+{
+	public:
+		AnalyzerSettingInterfaceNumberList() : mNumber(0.0) {}
+
+		double GetNumber() { return mNumber; }
+		void SetNumber(double number) { mNumber = number; }
+		void AddNumber(double number, const char* /*str*/, const char* /*tooltip*/) { mNumbers.push_back(number); }
+		void ClearNumbers() { mNumbers.clear(); }
+
+		double mNumber;
+		std::vector<double> mNumbers;
+};
+
+class AnalyzerSettingInterfaceInteger : public AnalyzerSettingInterface
+{
+	public:
+		AnalyzerSettingInterfaceInteger() : mInteger(0), mMin(0), mMax(0) {}
+
+		int GetInteger() { return mInteger; }
+		void SetInteger(int integer) { mInteger = integer; }
+		void SetMax(int max) { mMax = max; }
+		void SetMin(int min) { mMin = min; }
+
+		int mInteger;
+		int mMin;
+		int mMax;
+};
+
+class AnalyzerSettingInterfaceText : public AnalyzerSettingInterface
+{
+	public:
+		enum TextType { NormalText, FilePath, FolderPath };
+
+		AnalyzerSettingInterfaceText() : mTextType(NormalText) {}
+
+		const char* GetText() { return mText.c_str(); }
+		void SetText(const char* text) { mText = text; }
+		TextType GetTextType() { return mTextType; }
+		void SetTextType(TextType text_type) { mTextType = text_type; }
+
+		std::string mText;
+		TextType mTextType;
+};
+
+class AnalyzerSettingInterfaceBool : public AnalyzerSettingInterface
+{
+	public:
+		AnalyzerSettingInterfaceBool() : mValue(false) {}
+
+		bool GetValue() { return mValue; }
+		void SetValue(bool value) { mValue = value; }
+		const char* GetCheckBoxText() { return mCheckBoxText.c_str(); }
+		void SetCheckBoxText(const char* text) { mCheckBoxText = text; }
+
+		bool mValue;
+		std::string mCheckBoxText;
+};
+
+#endif // ANALYZER_SETTING_INTERFACE
@@ -0,0 +1,73 @@
+#ifndef ANALYZER_SETTINGS
+#define ANALYZER_SETTINGS
+
+#include <deque>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "LogicPublicTypes.h"
+#include "AnalyzerSettingInterface.h"
+
+/* Settings archive, values separated by spaces and strings quoted */
+class SimpleArchive
+{
+	public:
+		void SetString(const char* archive_string) { mIn.clear(); mIn.str(archive_string); }
+		const char* GetString() { mString = mOut.str(); return mString.c_str(); }
+
+		bool operator<<(U64 data) { mOut << data << " "; return true; }
+		bool operator<<(U32 data) { mOut << data << " "; return true; }
+		bool operator<<(S64 data) { mOut << data << " "; return true; }
+		bool operator<<(S32 data) { mOut << data << " "; return true; }
+		bool operator<<(double data) { mOut << data << " "; return true; }
+		bool operator<<(bool data) { mOut << data << " "; return true; }
+		bool operator<<(const char* data) { mOut << "\"" << data << "\" "; return true; }
+		bool operator<<(Channel& data) { mOut << data.mDeviceId << " " << data.mChannelIndex << " "; return true; }
+
+		bool operator>>(U64& data) { return bool(mIn >> data); }
+		bool operator>>(U32& data) { return bool(mIn >> data); }
+		bool operator>>(S64& data) { return bool(mIn >> data); }
+		bool operator>>(S32& data) { return bool(mIn >> data); }
+		bool operator>>(double& data) { return bool(mIn >> data); }
+		bool operator>>(bool& data) { return bool(mIn >> data); }
+		bool operator>>(char const** data);
+		bool operator>>(Channel& data) { return bool(mIn >> data.mDeviceId >> data.mChannelIndex); }
+
+	protected:
+		std::stringstream mOut;
+		std::stringstream mIn;
+		std::string mString;
+
+		/* Strings read, kept for the archive's lifetime */
+		std::deque<std::string> mStrings;
+};
+
+class AnalyzerSettings
+{
+	public:
+		virtual ~AnalyzerSettings() {}
+
+		virtual bool SetSettingsFromInterfaces() = 0;
+		virtual void LoadSettings(const char* settings) = 0;
+		virtual const char* SaveSettings() = 0;
+
+		/* Error text set by the last failed SetSettingsFromInterfaces */
+		const char* GetErrorText() const { return mErrorText.c_str(); }
+
+	protected:
+		void ClearChannels() {}
+		void AddChannel(Channel& /*channel*/, const char* /*channel_label*/, bool /*is_used*/) {}
+		void SetErrorText(const char* error_text) { mErrorText = error_text; }
+		void AddInterface(AnalyzerSettingInterface* analyzer_setting_interface) { mInterfaces.push_back(analyzer_setting_interface); }
+		void AddExportOption(U32 /*user_id*/, const char* /*menu_text*/) {}
+		void AddExportExtension(U32 /*user_id*/, const char* /*extension_description*/, const char* /*extension*/) {}
+		const char* SetReturnString(const char* str) { mReturnString = str; return mReturnString.c_str(); }
+		bool GetUseSystemDisplayBase() { return true; }
+
+		std::string mErrorText;
+		std::string mReturnString;
+		std::vector<AnalyzerSettingInterface*> mInterfaces;
+};
+
+#endif // ANALYZER_SETTINGS
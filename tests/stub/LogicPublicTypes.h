@@ -0,0 +1,44 @@
+#ifndef LOGIC_PUBLIC_TYPES
+#define LOGIC_PUBLIC_TYPES
+
+/*
+** Stub of the Analyzer SDK for offline tests, declaring only what the analyzer
+** uses. The real SDK is fetched when the plugin itself is configured.
+*/
+
+#include <cstdint>
+#include <memory>
+
+typedef signed char S8;
+typedef short S16;
+typedef int S32;
+typedef long long int S64;
+
+typedef unsigned char U8;
+typedef unsigned short U16;
+typedef unsigned int U32;
+typedef unsigned long long int U64;
+
+#define ANALYZER_EXPORT
+
+enum DisplayBase { Binary, Decimal, Hexadecimal, ASCII, AsciiHex };
+
+enum BitState { BIT_LOW, BIT_HIGH };
+#define Toggle(x) ( x == BIT_LOW ? BIT_HIGH : BIT_LOW )
+
+class Channel
+{
+	public:
+		Channel() : mDeviceId(0), mChannelIndex(0) {}
+		Channel(U64 device_id, U32 channel_index) : mDeviceId(device_id), mChannelIndex(channel_index) {}
+
+		bool operator==(const Channel& other) const { return (mDeviceId == other.mDeviceId) && (mChannelIndex == other.mChannelIndex); }
+		bool operator!=(const Channel& other) const { return !(*this == other); }
+
+		U64 mDeviceId;
+		U32 mChannelIndex;
+};
+
+#define UNDEFINED_CHANNEL Channel(0xFFFFFFFFFFFFFFFFull, 0xFFFFFFFF)
+
+#endif // LOGIC_PUBLIC_TYPES
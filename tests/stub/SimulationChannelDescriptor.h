@@ -0,0 +1,34 @@
+#ifndef SIMULATION_CHANNEL_DESCRIPTOR
+#define SIMULATION_CHANNEL_DESCRIPTOR
+
+#include <vector>
+
+#include "LogicPublicTypes.h"
+
+/* Simulated channel, every transition is kept */
+class SimulationChannelDescriptor
+{
+	public:
+		SimulationChannelDescriptor() : mInitialBitState(BIT_LOW), mCurrentBitState(BIT_LOW), mSample(0), mSampleRate(0) {}
+
+		void Transition() { mEdges.push_back(mSample); mCurrentBitState = Toggle(mCurrentBitState); }
+		void TransitionIfNeeded(BitState bit_state) { if (bit_state != mCurrentBitState) Transition(); }
+		void Advance(U32 num_samples_to_advance) { mSample += num_samples_to_advance; }
+		BitState GetCurrentBitState() { return mCurrentBitState; }
+		U64 GetCurrentSampleNumber() { return mSample; }
+		void SetChannel(Channel& channel) { mChannel = channel; }
+		void SetSampleRate(U32 sample_rate_hz) { mSampleRate = sample_rate_hz; }
+		void SetInitialBitState(BitState initial_bit_state) { mInitialBitState = initial_bit_state; mCurrentBitState = initial_bit_state; }
+
+		/* Transitions so far (samples), and the state before the first */
+		std::vector<U64> mEdges;
+		BitState mInitialBitState;
+
+	protected:
+		BitState mCurrentBitState;
+		U64 mSample;
+		U32 mSampleRate;
+		Channel mChannel;
+};
+
+#endif // SIMULATION_CHANNEL_DESCRIPTOR
@@ -0,0 +1,302 @@
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include "Analyzer.h"
+#include "AnalyzerChannelData.h"
+#include "AnalyzerHelpers.h"
+#include "AnalyzerResults.h"
+#include "AnalyzerSettings.h"
+
+bool SimpleArchive::operator>>(char const** data)
+{
+	/* Skip to opening quote, then read up to closing one */
+	char c;
+	while (mIn.get(c) && ('"' != c)) {}
+	if (!mIn) return false;
+
+	std::string str;
+	while (mIn.get(c) && ('"' != c)) str += c;
+
+	mStrings.push_back(str);
+	*data = mStrings.back().c_str();
+	return true;
+}
+
+FrameV2::FrameV2()
+	: mInternals(new FrameV2Data)
+{
+	mInternals->uiNumFields = 0;
+}
+
+FrameV2::~FrameV2()
+{
+	delete mInternals;
+}
+
+void FrameV2::AddString(const char* key, const char* value)
+{
+	if (mInternals->uiNumFields >= FrameV2Data::mMaxFields) return;
+	snprintf(mInternals->acFields[mInternals->uiNumFields++], FrameV2Data::mMaxFieldLength, "%s=%s", key, value);
+}
+
+void FrameV2::AddDouble(const char* key, double value)
+{
+	if (mInternals->uiNumFields >= FrameV2Data::mMaxFields) return;
+	snprintf(mInternals->acFields[mInternals->uiNumFields++], FrameV2Data::mMaxFieldLength, "%s=%g", key, value);
+}
+
+void FrameV2::AddInteger(const char* key, S64 value)
+{
+	if (mInternals->uiNumFields >= FrameV2Data::mMaxFields) return;
+	snprintf(mInternals->acFields[mInternals->uiNumFields++], FrameV2Data::mMaxFieldLength, "%s=%lld", key, value);
+}
+
+void FrameV2::AddBoolean(const char* key, bool value)
+{
+	AddString(key, value ? "true" : "false");
+}
+
+void FrameV2::AddByte(const char* key, U8 value)
+{
+	AddInteger(key, value);
+}
+
+void FrameV2::AddByteArray(const char* key, const U8* data, U64 length)
+{
+	if (mInternals->uiNumFields >= FrameV2Data::mMaxFields) return;
+
+	char* field = mInternals->acFields[mInternals->uiNumFields++];
+	int used = snprintf(field, FrameV2Data::mMaxFieldLength, "%s=", key);
+	for (U64 i = 0; (i < length) && (used < int(FrameV2Data::mMaxFieldLength)); i++)
+	{
+		used += snprintf(field + used, FrameV2Data::mMaxFieldLength - used, "%s%02x", (i > 0) ? " " : "", data[i]);
+	}
+}
+
+AnalyzerResults::AnalyzerResults()
+	: mNumFrames(0), mNumMarkers(0), mNumFramesV2(0), mNumPackets(0), mRetainResults(true), mPacketFirstFrame(0)
+{
+}
+
+AnalyzerResults::~AnalyzerResults()
+{
+}
+
+void AnalyzerResults::AddMarker(U64 sample_number, MarkerType marker_type, Channel& /*channel*/)
+{
+	mNumMarkers++;
+	if (!mRetainResults) return;
+
+	StubMarker marker = {sample_number, marker_type};
+	mMarkers.push_back(marker);
+}
+
+U64 AnalyzerResults::AddFrame(const Frame& frame)
+{
+	if (mRetainResults) mFrames.push_back(frame);
+	return mNumFrames++;
+}
+
+void AnalyzerResults::AddFrameV2(const FrameV2& frame, const char* type, U64 starting_sample, U64 ending_sample)
+{
+	mNumFramesV2++;
+	if (!mRetainResults) return;
+
+	StubFrameV2Record record;
+	record.type = type;
+	record.uiStart = starting_sample;
+	record.uiEnd = ending_sample;
+	for (U32 i = 0; i < frame.mInternals->uiNumFields; i++) record.fields.push_back(frame.mInternals->acFields[i]);
+	mFramesV2.push_back(record);
+}
+
+U64 AnalyzerResults::CommitPacketAndStartNewPacket()
+{
+	if (mRetainResults) mPackets.push_back(std::make_pair(mPacketFirstFrame, mNumFrames - 1));
+	mPacketFirstFrame = mNumFrames;
+	return mNumPackets++;
+}
+
+void AnalyzerResults::CancelPacketAndStartNewPacket()
+{
+	mPacketFirstFrame = mNumFrames;
+}
+
+U64 AnalyzerResults::GetPacketContainingFrame(U64 frame_id)
+{
+	for (U64 i = 0; i < mPackets.size(); i++)
+	{
+		if ((frame_id >= mPackets[i].first) && (frame_id <= mPackets[i].second)) return i;
+	}
+
+	return INVALID_RESULT_INDEX;
+}
+
+void AnalyzerResults::GetFramesContainedInPacket(U64 packet_id, U64* first_frame_id, U64* last_frame_id)
+{
+	*first_frame_id = mPackets[packet_id].first;
+	*last_frame_id = mPackets[packet_id].second;
+}
+
+static std::string JoinStrings(const char* str1, const char* str2, const char* str3, const char* str4, const char* str5, const char* str6)
+{
+	std::string str(str1);
+	const char* rest[] = {str2, str3, str4, str5, str6};
+	for (size_t i = 0; i < (sizeof(rest) / sizeof(rest[0])); i++)
+	{
+		if (NULL != rest[i]) str += rest[i];
+	}
+
+	return str;
+}
+
+void AnalyzerResults::AddResultString(const char* str1, const char* str2, const char* str3, const char* str4, const char* str5, const char* str6)
+{
+	mResultStrings.push_back(JoinStrings(str1, str2, str3, str4, str5, str6));
+}
+
+void AnalyzerResults::AddTabularText(const char* str1, const char* str2, const char* str3, const char* str4, const char* str5, const char* str6)
+{
+	mTabularText.push_back(JoinStrings(str1, str2, str3, str4, str5, str6));
+}
+
+AnalyzerChannelData::AnalyzerChannelData()
+	: mNextEdge(0), mSource(NULL), mSample(0), mBitState(BIT_HIGH)
+{
+}
+
+void AnalyzerChannelData::StubSetEdges(BitState initial_bit_state, const std::vector<U64>& edges)
+{
+	mEdges = edges;
+	mNextEdge = 0;
+	mSource = NULL;
+	mSample = 0;
+	mBitState = initial_bit_state;
+}
+
+void AnalyzerChannelData::StubSetSource(BitState initial_bit_state, StubEdgeSource* source)
+{
+	mEdges.clear();
+	mNextEdge = 0;
+	mSource = source;
+	mSample = 0;
+	mBitState = initial_bit_state;
+}
+
+bool AnalyzerChannelData::HaveNextEdge()
+{
+	if (mNextEdge < mEdges.size()) return true;
+	if (NULL == mSource) return false;
+
+	/* Drop edges passed, keeping capacity */
+	mEdges.clear();
+	mNextEdge = 0;
+	while (mEdges.empty())
+	{
+		if (!mSource->NextEdges(mEdges))
+		{
+			mSource = NULL;
+			break;
+		}
+	}
+
+	return !mEdges.empty();
+}
+
+U32 AnalyzerChannelData::Advance(U32 num_samples)
+{
+	return AdvanceToAbsPosition(mSample + num_samples);
+}
+
+U32 AnalyzerChannelData::AdvanceToAbsPosition(U64 sample_number)
+{
+	U32 transitions = 0;
+	while (HaveNextEdge() && (mEdges[mNextEdge] <= sample_number))
+	{
+		mNextEdge++;
+		mBitState = Toggle(mBitState);
+		transitions++;
+	}
+	mSample = sample_number;
+
+	return transitions;
+}
+
+void AnalyzerChannelData::AdvanceToNextEdge()
+{
+	if (!HaveNextEdge()) throw StubEndOfData();
+
+	mSample = mEdges[mNextEdge++];
+	mBitState = Toggle(mBitState);
+}
+
+U64 AnalyzerChannelData::GetSampleOfNextEdge()
+{
+	if (!HaveNextEdge()) throw StubEndOfData();
+
+	return mEdges[mNextEdge];
+}
+
+bool AnalyzerChannelData::WouldAdvancingCauseTransition(U32 num_samples)
+{
+	return WouldAdvancingToAbsPositionCauseTransition(mSample + num_samples);
+}
+
+bool AnalyzerChannelData::WouldAdvancingToAbsPositionCauseTransition(U64 sample_number)
+{
+	return HaveNextEdge() && (mEdges[mNextEdge] <= sample_number);
+}
+
+bool AnalyzerChannelData::DoMoreTransitionsExistInCurrentData()
+{
+	return HaveNextEdge();
+}
+
+void AnalyzerHelpers::GetNumberString(U64 number, DisplayBase display_base, U32 num_data_bits, char* result_string, U32 result_string_max_length)
+{
+	if (Hexadecimal == display_base)
+	{
+		snprintf(result_string, result_string_max_length, "0x%0*llX", int((num_data_bits + 3) / 4), number);
+	}
+	else if (Binary == display_base)
+	{
+		std::string str("0b");
+		for (int i = int(num_data_bits) - 1; i >= 0; i--) str += ((number >> i) & 1) ? '1' : '0';
+		snprintf(result_string, result_string_max_length, "%s", str.c_str());
+	}
+	else
+	{
+		snprintf(result_string, result_string_max_length, "%llu", number);
+	}
+}
+
+void AnalyzerHelpers::GetTimeString(U64 sample, U64 trigger_sample, U32 sample_rate_hz, char* result_string, U32 result_string_max_length)
+{
+	snprintf(result_string, result_string_max_length, "%.9f", (double(sample) - double(trigger_sample)) / sample_rate_hz);
+}
+
+void AnalyzerHelpers::Assert(const char* message)
+{
+	throw std::runtime_error(message);
+}
+
+U64 AnalyzerHelpers::AdjustSimulationTargetSample(U64 target_sample, U32 sample_rate, U32 simulation_sample_rate)
+{
+	return (target_sample * simulation_sample_rate) / sample_rate;
+}
+
+void* AnalyzerHelpers::StartFile(const char* file, bool is_binary)
+{
+	return fopen(file, is_binary ? "wb" : "w");
+}
+
+void AnalyzerHelpers::AppendToFile(const U8* data, U32 data_length, void* file)
+{
+	fwrite(data, 1, data_length, (FILE*)file);
+}
+
+void AnalyzerHelpers::EndFile(void* file)
+{
+	fclose((FILE*)file);
+}
@@ -0,0 +1,597 @@
+/*
+** Compares two ADB transaction traces, as written by the binary trace export or
+** recorded from the live stream, reporting transactions added, missing and
+** changed, along with how timing drifts between them.
+**
+** Both traces are read in a single pass, in constant memory, and merge-joined
+** in sequence order. The traces are first aligned on an anchor, a run of
+** transactions agreeing in content and relative timing within a short look
+** ahead, so captures needn't start on the same transaction. After that a
+** transaction in the second trace pairs with one in the first if it starts
+** within the tolerance of where it's expected. The expected offset follows
+** each pairing, so slow drift between capture clocks doesn't break pairing
+** however long the traces run. A run of unpaired transactions, such as a gap
+** in one capture, has the traces aligned again on a new anchor.
+**
+** Usage: adb_trace_diff [-t <tolerance ms>] [-q] <first trace> <second trace>
+**
+** Differences are written to stdout as CSV, a summary to stderr. Exit status is
+** 0 if the traces match, 1 if they differ, 2 on error.
+*/
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+typedef uint8_t U8;
+typedef uint32_t U32;
+typedef uint64_t U64;
+
+/* Record layout, see Live Stream in README.md */
+static const size_t mRecordSize = 40;
+
+/* Records read at a time */
+static const size_t mReadRecords = 64 * 1024;
+
+/* Default pairing tolerance */
+static const double mDefaultToleranceMs = 1.0;
+
+/* Records read ahead of each trace when looking for an anchor, and transactions that must agree to form one */
+static const size_t mSearchRecords = 64;
+static const size_t mAnchorRecords = 4;
+
+/* Consecutive unpaired transactions after which the traces are aligned again */
+static const U32 mResyncMisses = 8;
+
+/* Decoded record */
+struct TraceRecord
+{
+	U32 uiSequence;
+	U32 uiDrops;
+	U64 uiStart;
+	U64 uiEnd;
+	U32 uiSampleRate;
+	U8 byCommand;
+	U8 uiDataLen;
+	bool bServiceRequested;
+	U8 abyData[8];
+
+	/* Start, seconds */
+	double dTime;
+};
+
+/* Load little endian values from record */
+static U32 LoadU32(const U8 *pabySource)
+{
+	U32 uiValue = 0;
+	for (int i = 3; i >= 0; i--) uiValue = (uiValue << 8) | pabySource[i];
+	return uiValue;
+}
+
+static U64 LoadU64(const U8 *pabySource)
+{
+	U64 uiValue = 0;
+	for (int i = 7; i >= 0; i--) uiValue = (uiValue << 8) | pabySource[i];
+	return uiValue;
+}
+
+/* Reads records from a trace file in large blocks */
+class TraceReader
+{
+	public:
+		TraceReader() : mFile(NULL), mOffset(0), mCount(0), mRecords(0), mDrops(0), mTruncated(false) {}
+		~TraceReader() { if (NULL != mFile) fclose(mFile); }
+
+		bool Open(const char* pszPath)
+		{
+			mPath = pszPath;
+			mFile = fopen(pszPath, "rb");
+			if (NULL == mFile) return false;
+
+			mBuffer.resize(mReadRecords * mRecordSize);
+			return true;
+		}
+
+		/* Next record, returns false at end of trace */
+		bool Next(TraceRecord* pRecord)
+		{
+			if (mOffset >= mCount)
+			{
+				size_t uiRead = fread(&mBuffer[0], 1, mBuffer.size(), mFile);
+
+				/* Partial record at end, from a recording cut short */
+				if (0 != (uiRead % mRecordSize)) mTruncated = true;
+
+				mCount = uiRead / mRecordSize;
+				mOffset = 0;
+				if (0 == mCount) return false;
+			}
+
+			const U8 *pabyRecord = &mBuffer[mOffset * mRecordSize];
+			mOffset++;
+
+			pRecord->uiSequence = LoadU32(&pabyRecord[0]);
+			pRecord->uiDrops = LoadU32(&pabyRecord[4]);
+			pRecord->uiStart = LoadU64(&pabyRecord[8]);
+			pRecord->uiEnd = LoadU64(&pabyRecord[16]);
+			pRecord->uiSampleRate = LoadU32(&pabyRecord[24]);
+			pRecord->byCommand = pabyRecord[28];
+			pRecord->uiDataLen = (pabyRecord[29] > 8) ? 8 : pabyRecord[29];
+			pRecord->bServiceRequested = (0 != (pabyRecord[30] & 0x01));
+			memcpy(pRecord->abyData, &pabyRecord[32], 8);
+			pRecord->dTime = (0 != pRecord->uiSampleRate) ? (double(pRecord->uiStart) / pRecord->uiSampleRate) : 0.0;
+
+			mRecords++;
+			mDrops = pRecord->uiDrops;
+
+			return true;
+		}
+
+		const char* GetPath() const { return mPath.c_str(); }
+		bool HadError() const { return (NULL != mFile) && (0 != ferror(mFile)); }
+		U64 GetRecords() const { return mRecords; }
+		U32 GetDrops() const { return mDrops; }
+		bool WasTruncated() const { return mTruncated; }
+
+	protected:
+		std::string mPath;
+		FILE* mFile;
+		std::vector<U8> mBuffer;
+		size_t mOffset;
+		size_t mCount;
+
+		/* Records read, drops reported by the latest record, partial record at end */
+		U64 mRecords;
+		U32 mDrops;
+		bool mTruncated;
+};
+
+/* Count, mean, deviation and range of a series, in constant memory */
+class RunningStatistics
+{
+	public:
+		RunningStatistics() : mCount(0), mMean(0.0), mM2(0.0), mMin(0.0), mMax(0.0) {}
+
+		void Add(double dValue)
+		{
+			/* Welford's method, stable over long series */
+			mCount++;
+			double dDelta = dValue - mMean;
+			mMean += dDelta / mCount;
+			mM2 += dDelta * (dValue - mMean);
+
+			if ((1 == mCount) || (dValue < mMin)) mMin = dValue;
+			if ((1 == mCount) || (dValue > mMax)) mMax = dValue;
+		}
+
+		U64 GetCount() const { return mCount; }
+		double GetMean() const { return mMean; }
+		double GetDeviation() const { return (mCount > 1) ? sqrt(mM2 / (mCount - 1)) : 0.0; }
+		double GetMin() const { return mMin; }
+		double GetMax() const { return mMax; }
+
+	protected:
+		U64 mCount;
+		double mMean;
+		double mM2;
+		double mMin;
+		double mMax;
+};
+
+/* Describe command as in a match pattern, <addr> <cmd> <reg> */
+static std::string FormatCommand(const TraceRecord& record)
+{
+	static const char* apszCommands[] = {"send_reset", "flush", "reserved", "reserved", "reserved", "reserved", "reserved", "reserved",
+										 "listen", "listen", "listen", "listen", "talk", "talk", "talk", "talk"};
+	U8 uiAddr = (record.byCommand >> 4) & 0x0f;
+	U8 uiCode = record.byCommand & 0x0f;
+	U8 uiReg = record.byCommand & 0x03;
+
+	char szCommand[32];
+	if (uiCode < 4)
+	{
+		/* Send reset / flush carry no register */
+		snprintf(szCommand, sizeof(szCommand), "%u %s", uiAddr, apszCommands[uiCode]);
+	}
+	else
+	{
+		snprintf(szCommand, sizeof(szCommand), "%u %s %u", uiAddr, apszCommands[uiCode], uiReg);
+	}
+
+	std::string command(szCommand);
+	if (record.bServiceRequested) command += " srq";
+	return command;
+}
+
+/* Data bytes as space separated hex */
+static std::string FormatData(const TraceRecord& record)
+{
+	static const char acHex[] = "0123456789abcdef";
+	std::string data;
+	for (U8 i = 0; i < record.uiDataLen; i++)
+	{
+		if (i > 0) data += ' ';
+		data += acHex[record.abyData[i] >> 4];
+		data += acHex[record.abyData[i] & 0x0f];
+	}
+	return data;
+}
+
+/* Output difference line, either record may be absent */
+static void OutputDifference(const char* pszDifference, const TraceRecord* pFirst, const TraceRecord* pSecond)
+{
+	printf("%s", pszDifference);
+	for (const TraceRecord* pRecord : {pFirst, pSecond})
+	{
+		if (NULL != pRecord)
+		{
+			printf(",%u,%.9f,%s,%s", pRecord->uiSequence, pRecord->dTime, FormatCommand(*pRecord).c_str(), FormatData(*pRecord).c_str());
+		}
+		else
+		{
+			printf(",,,,");
+		}
+	}
+	printf("\n");
+}
+
+/* Compare contents of paired transactions */
+static bool SameTransaction(const TraceRecord& first, const TraceRecord& second)
+{
+	return    (first.byCommand == second.byCommand)
+		   && (first.uiDataLen == second.uiDataLen)
+		   && (first.bServiceRequested == second.bServiceRequested)
+		   && (0 == memcmp(first.abyData, second.abyData, first.uiDataLen));
+}
+
+/* Merge-joins two traces, pairing transactions in sequence order within a timing tolerance */
+class TraceDiff
+{
+	public:
+		TraceDiff(TraceReader* pFirst, TraceReader* pSecond, double dTolerance, bool bQuiet)
+			: mTolerance(dTolerance), mQuiet(bQuiet), mAligned(false), mOffset(0.0), mMisses(0),
+			  mMatched(0), mChanged(0), mMissing(0), mAdded(0), mAnchors(0), mDrift(0.0), mFirstPaired(0.0), mLastPaired(0.0)
+		{
+			mReaders[0] = pFirst;
+			mReaders[1] = pSecond;
+			mEnd[0] = mEnd[1] = false;
+		}
+
+		/* Compare traces to the end, outputting differences */
+		void Run()
+		{
+			if (!mQuiet) printf("Diff,Seq A,Time A [s],Command A,Data A,Seq B,Time B [s],Command B,Data B\n");
+
+			for (;;)
+			{
+				Fill(0, 1);
+				Fill(1, 1);
+				if (mQueues[0].empty() && mQueues[1].empty()) break;
+
+				if (!mAligned)
+				{
+					Align();
+				}
+				else
+				{
+					Step();
+				}
+			}
+		}
+
+		/* Output summary to stderr */
+		void OutputSummary() const
+		{
+			fprintf(stderr, "Matched %llu, changed %llu, missing from B %llu, added in B %llu\n",
+					(unsigned long long)mMatched, (unsigned long long)mChanged, (unsigned long long)mMissing, (unsigned long long)mAdded);
+			if (mAnchors > 1) fprintf(stderr, "Traces realigned %llu times\n", (unsigned long long)(mAnchors - 1));
+
+			if (mError.GetCount() > 0)
+			{
+				/* Drift is how far pairing moved the offset between traces, per second of the first trace */
+				double dSpan = mLastPaired - mFirstPaired;
+				fprintf(stderr, "Pairing error [us]: mean %.3f, deviation %.3f, min %.3f, max %.3f\n",
+						mError.GetMean() * 1e6, mError.GetDeviation() * 1e6, mError.GetMin() * 1e6, mError.GetMax() * 1e6);
+				fprintf(stderr, "Drift: %.3f us over %.3f s", mDrift * 1e6, dSpan);
+				if (dSpan > 0.0) fprintf(stderr, " (%.3f ppm)", (mDrift / dSpan) * 1e6);
+				fprintf(stderr, "\n");
+			}
+		}
+
+		bool Differs() const { return (0 != mChanged) || (0 != mMissing) || (0 != mAdded); }
+
+	protected:
+		/* Read ahead until a trace has uiCount records queued, or has ended */
+		void Fill(int iTrace, size_t uiCount)
+		{
+			TraceRecord record;
+			while ((mQueues[iTrace].size() < uiCount) && !mEnd[iTrace])
+			{
+				if (mReaders[iTrace]->Next(&record))
+				{
+					mQueues[iTrace].push_back(record);
+				}
+				else
+				{
+					mEnd[iTrace] = true;
+				}
+			}
+		}
+
+		/* Align traces on the nearest run of transactions agreeing in content and relative timing */
+		void Align()
+		{
+			Fill(0, mSearchRecords);
+			Fill(1, mSearchRecords);
+
+			size_t uiFirst, uiSecond;
+			if (FindAnchor(&uiFirst, &uiSecond))
+			{
+				/* Anything ahead of the anchor has no counterpart */
+				while (uiFirst-- > 0) Missing();
+				while (uiSecond-- > 0) Added();
+
+				mOffset = mQueues[1].front().dTime - mQueues[0].front().dTime;
+				mAligned = true;
+				mMisses = 0;
+				mAnchors++;
+				return;
+			}
+
+			/* No anchor in sight, give up on the older half of what was read ahead */
+			for (size_t i = 0; (i < (mSearchRecords / 2)) && !mQueues[0].empty(); i++) Missing();
+			for (size_t i = 0; (i < (mSearchRecords / 2)) && !mQueues[1].empty(); i++) Added();
+		}
+
+		/*
+		** Search read ahead records for an anchor. Periodic polling can agree in
+		** content at more than one alignment, so the one whose timing agrees
+		** best is taken, nearest the front of both traces if there's a tie.
+		*/
+		bool FindAnchor(size_t* puiFirst, size_t* puiSecond) const
+		{
+			bool bFound = false;
+			double dBestError = 0.0;
+			*puiFirst = 0;
+			*puiSecond = 0;
+
+			for (size_t i = 0; i < mQueues[0].size(); i++)
+			{
+				for (size_t j = 0; j < mQueues[1].size(); j++)
+				{
+					double dError;
+					if (!IsAnchor(i, j, &dError)) continue;
+
+					if (!bFound || (dError < dBestError) || ((dError == dBestError) && ((i + j) < (*puiFirst + *puiSecond))))
+					{
+						bFound = true;
+						dBestError = dError;
+						*puiFirst = i;
+						*puiSecond = j;
+					}
+				}
+			}
+
+			return bFound;
+		}
+
+		/* Check mAnchorRecords transactions from given positions agree (fewer if a trace ends first), summing their timing error */
+		bool IsAnchor(size_t uiFirst, size_t uiSecond, double* pdError) const
+		{
+			const std::deque<TraceRecord>& first = mQueues[0];
+			const std::deque<TraceRecord>& second = mQueues[1];
+			double dOffset = second[uiSecond].dTime - first[uiFirst].dTime;
+
+			*pdError = 0.0;
+			for (size_t k = 0; k < mAnchorRecords; k++)
+			{
+				if ((uiFirst + k) >= first.size()) return mEnd[0] && (k > 0);
+				if ((uiSecond + k) >= second.size()) return mEnd[1] && (k > 0);
+
+				const TraceRecord& a = first[uiFirst + k];
+				const TraceRecord& b = second[uiSecond + k];
+				if (!SameTransaction(a, b)) return false;
+
+				double dDistance = fabs(Distance(a, b, dOffset));
+				if (dDistance > mTolerance) return false;
+				*pdError += dDistance;
+			}
+
+			return true;
+		}
+
+		/* Pair, or report unpaired, the front transaction of either trace */
+		void Step()
+		{
+			if (mQueues[0].empty())
+			{
+				Added();
+				return;
+			}
+			if (mQueues[1].empty())
+			{
+				Missing();
+				return;
+			}
+
+			const TraceRecord& first = mQueues[0].front();
+			const TraceRecord& second = mQueues[1].front();
+			double dDistance = Distance(first, second, mOffset);
+
+			if (fabs(dDistance) <= mTolerance)
+			{
+				Pair(dDistance);
+				mMisses = 0;
+				return;
+			}
+
+			/* Whichever is earlier has nothing close enough in the other trace */
+			if (dDistance > 0.0)
+			{
+				Missing();
+			}
+			else
+			{
+				Added();
+			}
+
+			/* Run of unpaired transactions, traces have probably slipped, so look for a new anchor */
+			if (++mMisses >= mResyncMisses) mAligned = false;
+		}
+
+		/* Distance of second transaction from where first is expected in second trace, to the nearest ns to drop rounding noise */
+		static double Distance(const TraceRecord& first, const TraceRecord& second, double dOffset)
+		{
+			return (round((second.dTime - first.dTime - dOffset) * 1e9) / 1e9) + 0.0;
+		}
+
+		/* Pair front transactions, following any drift */
+		void Pair(double dDistance)
+		{
+			const TraceRecord& first = mQueues[0].front();
+			const TraceRecord& second = mQueues[1].front();
+
+			if (SameTransaction(first, second))
+			{
+				mMatched++;
+			}
+			else
+			{
+				mChanged++;
+				if (!mQuiet) OutputDifference("changed", &first, &second);
+			}
+
+			mError.Add(dDistance);
+			if (1 == mError.GetCount()) mFirstPaired = first.dTime;
+			mLastPaired = first.dTime;
+			mDrift += dDistance;
+			mOffset += dDistance;
+
+			mQueues[0].pop_front();
+			mQueues[1].pop_front();
+		}
+
+		/* Front transaction of first trace has no counterpart */
+		void Missing()
+		{
+			mMissing++;
+			if (!mQuiet) OutputDifference("missing", &mQueues[0].front(), NULL);
+			mQueues[0].pop_front();
+		}
+
+		/* Front transaction of second trace has no counterpart */
+		void Added()
+		{
+			mAdded++;
+			if (!mQuiet) OutputDifference("added", NULL, &mQueues[1].front());
+			mQueues[1].pop_front();
+		}
+
+		/* Traces, records read ahead from each, whether each has ended */
+		TraceReader* mReaders[2];
+		std::deque<TraceRecord> mQueues[2];
+		bool mEnd[2];
+
+		/* Options */
+		double mTolerance;
+		bool mQuiet;
+
+		/* Alignment, offset of second trace from first, consecutive unpaired transactions */
+		bool mAligned;
+		double mOffset;
+		U32 mMisses;
+
+		/* Counts and timing */
+		U64 mMatched, mChanged, mMissing, mAdded, mAnchors;
+		RunningStatistics mError;
+		double mDrift;
+		double mFirstPaired, mLastPaired;
+};
+
+static void Usage()
+{
+	fprintf(stderr, "usage: adb_trace_diff [-t <tolerance ms>] [-q] <first trace> <second trace>\n"
+					"  -t  largest difference in start time for transactions to pair, default %.1f ms\n"
+					"  -q  summary only\n", mDefaultToleranceMs);
+}
+
+int main(int argc, char** argv)
+{
+	double dTolerance = mDefaultToleranceMs / 1000.0;
+	bool bQuiet = false;
+	const char* apszPaths[2] = {NULL, NULL};
+	int iPaths = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if ((0 == strcmp(argv[i], "-t")) && ((i + 1) < argc))
+		{
+			char* pszEnd;
+			double dMs = strtod(argv[++i], &pszEnd);
+			if (('\0' != *pszEnd) || !(dMs >= 0.0))
+			{
+				Usage();
+				return 2;
+			}
+			dTolerance = dMs / 1000.0;
+		}
+		else if (0 == strcmp(argv[i], "-q"))
+		{
+			bQuiet = true;
+		}
+		else if ((iPaths < 2) && ('-' != argv[i][0]))
+		{
+			apszPaths[iPaths++] = argv[i];
+		}
+		else
+		{
+			Usage();
+			return 2;
+		}
+	}
+
+	if (iPaths != 2)
+	{
+		Usage();
+		return 2;
+	}
+
+	TraceReader aReaders[2];
+	for (int i = 0; i < 2; i++)
+	{
+		if (!aReaders[i].Open(apszPaths[i]))
+		{
+			fprintf(stderr, "adb_trace_diff: can't open %s\n", apszPaths[i]);
+			return 2;
+		}
+	}
+
+	TraceDiff diff(&aReaders[0], &aReaders[1], dTolerance, bQuiet);
+	diff.Run();
+
+	for (int i = 0; i < 2; i++)
+	{
+		if (aReaders[i].HadError())
+		{
+			fprintf(stderr, "adb_trace_diff: error reading %s\n", aReaders[i].GetPath());
+			return 2;
+		}
+	}
+
+	/* Summary */
+	for (int i = 0; i < 2; i++)
+	{
+		fprintf(stderr, "%s: %s, %llu transactions", (0 == i) ? "A" : "B", aReaders[i].GetPath(), (unsigned long long)aReaders[i].GetRecords());
+		if (aReaders[i].GetDrops() > 0) fprintf(stderr, ", %u dropped while recording", aReaders[i].GetDrops());
+		if (aReaders[i].WasTruncated()) fprintf(stderr, ", partial record at end ignored");
+		fprintf(stderr, "\n");
+	}
+	diff.OutputSummary();
+
+	return diff.Differs() ? 1 : 0;
+}